@@ -3,64 +3,981 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstdint>
+#include <cstring>
+#include <new>
+#include <algorithm>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include <bit>
+
+#pragma GCC target("avx,avx2,fma")
+
+#include <immintrin.h>
 
 namespace {
-    template <typename T, typename Cmp> auto merge_sort(
+    // Length of the runs which are sorted in place before merging.
+    // Such run fits into a couple of cache lines, so the first pass never leaves L1
+    constexpr std::size_t RUN_LENGTH = 32;
+
+    template <typename T, typename Cmp> void insertion_sort(
             T* const arr,
             const std::size_t left_border,
             const std::size_t right_border,
             const Cmp cmp
     ) {
-        if (left_border == right_border)
-            return;
+        for (auto i = left_border + 1; i < right_border; ++i) {
+            const auto elem = arr[i];
+            auto q = i;
+
+            for (; q > left_border && cmp(elem, arr[q - 1]); --q)
+                arr[q] = arr[q - 1];
+
+            arr[q] = elem;
+        }
+    }
+
+    // Merges [left_border, mid) and [mid, right_border) of src into the same range of dst
+
+    template <typename T, typename Cmp> void merge(
+            const T* const src,
+            T* const dst,
+            const std::size_t left_border,
+            const std::size_t mid,
+            const std::size_t right_border,
+            const Cmp cmp
+    ) {
+        auto i = left_border, q = mid;
+        auto* holder_elem = dst + left_border;
+
+        while (i < mid && q < right_border)
+            *holder_elem++ = cmp(src[q], src[i]) ? src[q++] : src[i++];
+
+        while (i < mid)
+            *holder_elem++ = src[i++];
+
+        while (q < right_border)
+            *holder_elem++ = src[q++];
+    }
+
+    // AVX2 kernels for sorting of ints in ascending order.
+    // Every __m256i holds 8 lanes, compare-exchange of lanes with their partners
+    // is done with min/max and blend, where bits of the mask mark lanes taking the maximum
+
+    namespace simd {
+        constexpr std::size_t LANES = 8;
+
+        template <int MaxLanes> inline __m256i exchange(const __m256i v, const __m256i partner) {
+            return _mm256_blend_epi32(_mm256_min_epi32(v, partner), _mm256_max_epi32(v, partner), MaxLanes);
+        }
+
+        inline __m256i swap_adjacent(const __m256i v) { return _mm256_shuffle_epi32(v, 0b10110001); }
+        inline __m256i swap_pairs(const __m256i v) { return _mm256_shuffle_epi32(v, 0b01001110); }
+        inline __m256i swap_halves(const __m256i v) { return _mm256_permute2x128_si256(v, v, 0x01); }
+
+        inline __m256i reverse(const __m256i v) {
+            return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+        }
+
+        // Sorts bitonic sequence of 8 lanes
+        inline __m256i bitonic_clean(__m256i v) {
+            v = exchange<0b11110000>(v, swap_halves(v));
+            v = exchange<0b11001100>(v, swap_pairs(v));
+            return exchange<0b10101010>(v, swap_adjacent(v));
+        }
+
+        // Bitonic sorting network for 8 lanes
+        inline __m256i sort8(__m256i v) {
+            v = exchange<0b01100110>(v, swap_adjacent(v));
+            v = exchange<0b00111100>(v, swap_pairs(v));
+            v = exchange<0b01011010>(v, swap_adjacent(v));
+            return bitonic_clean(v);
+        }
+
+        // Merges two sorted vectors: lo gets 8 smallest elements, hi gets 8 biggest
+        inline void merge16(__m256i& lo, __m256i& hi) {
+            const auto rev = reverse(hi);
+            const auto min = _mm256_min_epi32(lo, rev);
+            const auto max = _mm256_max_epi32(lo, rev);
+            lo = bitonic_clean(min);
+            hi = bitonic_clean(max);
+        }
+
+        inline __m256i load(const int* const ptr) {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+        }
+
+        inline void store(int* const ptr, const __m256i v) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), v);
+        }
+
+        // Sorts 32 ints entirely in registers
+        inline void sort32(int* const arr) {
+            auto a = sort8(load(arr));
+            auto b = sort8(load(arr + LANES));
+            auto c = sort8(load(arr + 2 * LANES));
+            auto d = sort8(load(arr + 3 * LANES));
+
+            merge16(a, b);
+            merge16(c, d);
+
+            // [a, b] and [c, d] are sorted, reversing [c, d] makes them one bitonic sequence
+            const auto rev_c = reverse(c);
+            const auto rev_d = reverse(d);
+
+            auto lo1 = _mm256_min_epi32(a, rev_d), hi1 = _mm256_max_epi32(a, rev_d);
+            auto lo2 = _mm256_min_epi32(b, rev_c), hi2 = _mm256_max_epi32(b, rev_c);
+
+            store(arr, bitonic_clean(_mm256_min_epi32(lo1, lo2)));
+            store(arr + LANES, bitonic_clean(_mm256_max_epi32(lo1, lo2)));
+            store(arr + 2 * LANES, bitonic_clean(_mm256_min_epi32(hi1, hi2)));
+            store(arr + 3 * LANES, bitonic_clean(_mm256_max_epi32(hi1, hi2)));
+        }
+
+        // Vectorized two-way merge: 8 elements are taken from the side
+        // with smaller head and merged with the 8 biggest elements left from the previous step
+
+        inline void merge(
+                const int* const src,
+                int* const dst,
+                const std::size_t left_border,
+                const std::size_t mid,
+                const std::size_t right_border
+        ) {
+            if (mid - left_border < LANES || right_border - mid < LANES) {
+                ::merge(src, dst, left_border, mid, right_border, std::less<int>());
+                return;
+            }
+
+            auto i = left_border, q = mid;
+            auto* holder_elem = dst + left_border;
+
+            auto lo = load(src + i);
+            auto hi = load(src + q);
+            i += LANES;
+            q += LANES;
+
+            merge16(lo, hi);
+            store(holder_elem, lo);
+            holder_elem += LANES;
+
+            while (i + LANES <= mid && q + LANES <= right_border) {
+                if (src[i] < src[q]) {
+                    lo = load(src + i);
+                    i += LANES;
+                } else {
+                    lo = load(src + q);
+                    q += LANES;
+                }
+
+                merge16(lo, hi);
+                store(holder_elem, lo);
+                holder_elem += LANES;
+            }
+
+            // Less than 8 elements are left on one of the sides,
+            // they are merged with hi first, then the result is merged with the other side
+
+            int rest[LANES];
+            int merged_rest[2 * LANES];
+            store(rest, hi);
+
+            const bool is_left_short = i + LANES > mid;
+            const auto* const short_begin = is_left_short ? src + i : src + q;
+            const auto* const short_end = is_left_short ? src + mid : src + right_border;
+            const auto* const long_begin = is_left_short ? src + q : src + i;
+            const auto* const long_end = is_left_short ? src + right_border : src + mid;
+
+            auto* const merged_end = std::merge(rest, rest + LANES, short_begin, short_end, merged_rest);
+            std::merge(merged_rest, merged_end, long_begin, long_end, holder_elem);
+        }
+    }
+
+    // Ints in ascending order are sorted with AVX2 kernels
+    template <typename T, typename Cmp> constexpr bool IS_SIMD_SORTABLE =
+            std::is_same_v<T, int> && std::is_same_v<Cmp, std::less<int>>;
+}
+
+// Bottom-up merge sort: runs of RUN_LENGTH are sorted with insertion sort,
+// then they are merged level by level. Single scratch buffer is allocated once,
+// each level merges from one buffer into another (ping-pong), so no copying back is required.
+// For ints with std::less runs are sorted with bitonic networks and merged with AVX2 kernel
+// @return false if the scratch buffer can't be allocated, then only runs are sorted
+
+template <typename T, typename Cmp> bool merge_sort(
+        T* const arr,
+        const std::size_t size,
+        const Cmp cmp
+) {
+    // Scratch buffer is raw memory which is assigned into and copied back with memcpy
+    static_assert(std::is_trivially_copyable_v<T>, "merge_sort requires trivially copyable elements");
+
+    for (std::size_t left_border = 0; left_border < size; left_border += RUN_LENGTH) {
+        if constexpr (IS_SIMD_SORTABLE<T, Cmp>) {
+            if (left_border + RUN_LENGTH <= size) {
+                simd::sort32(arr + left_border);
+                continue;
+            }
+        }
+
+        insertion_sort(arr, left_border, std::min(left_border + RUN_LENGTH, size), cmp);
+    }
+
+    if (size <= RUN_LENGTH)
+        return true;
+
+    auto* const sort_holder = reinterpret_cast<T*>(std::malloc(size * sizeof(T)));
+
+    if (sort_holder == nullptr)
+        return false;
+
+    auto* src = arr;
+    auto* dst = sort_holder;
+
+    for (auto width = RUN_LENGTH; width < size; width <<= 1) {
+        for (std::size_t left_border = 0; left_border < size; left_border += width << 1) {
+            const auto mid = std::min(left_border + width, size);
+            const auto right_border = std::min(left_border + (width << 1), size);
+
+            if constexpr (IS_SIMD_SORTABLE<T, Cmp>)
+                simd::merge(src, dst, left_border, mid, right_border);
+            else
+                merge(src, dst, left_border, mid, right_border, cmp);
+        }
+
+        std::swap(src, dst);
+    }
+
+    if (src != arr)
+        std::memcpy(arr, src, size * sizeof(T));
+
+    std::free(sort_holder);
+    return true;
+}
+
+namespace {
+    namespace pdq {
+        // Partitions smaller than it are sorted with insertion sort
+        constexpr std::size_t INSERTION_SORT_THRESHOLD = 24;
+
+        // Partitions larger than it choose pivot with Tukey's ninther instead of median of 3
+        constexpr std::size_t NINTHER_THRESHOLD = 128;
+
+        // Insertion sort of an already partitioned range gives up after such number of moves
+        constexpr std::size_t PARTIAL_INSERTION_SORT_LIMIT = 8;
+
+        // Number of elements scanned at once by branchless partition, offsets fit into unsigned char
+        constexpr std::size_t BLOCK_SIZE = 64;
+
+        template <typename T, typename Cmp> void sort2(T* const a, T* const b, const Cmp cmp) {
+            if (cmp(*b, *a))
+                std::swap(*a, *b);
+        }
+
+        template <typename T, typename Cmp> void sort3(T* const a, T* const b, T* const c, const Cmp cmp) {
+            sort2(a, b, cmp);
+            sort2(b, c, cmp);
+            sort2(a, b, cmp);
+        }
+
+        // Insertion sort which stops when too many elements are moved.
+        // Returns true if the range was sorted
+
+        template <typename T, typename Cmp> bool partial_insertion_sort(
+                T* const arr,
+                const std::size_t left_border,
+                const std::size_t right_border,
+                const Cmp cmp
+        ) {
+            std::size_t moves = 0;
+
+            for (auto i = left_border + 1; i < right_border; ++i) {
+                if (!cmp(arr[i], arr[i - 1]))
+                    continue;
+
+                T elem = std::move(arr[i]);
+                auto q = i;
+
+                for (; q > left_border && cmp(elem, arr[q - 1]); --q)
+                    arr[q] = std::move(arr[q - 1]);
+
+                arr[q] = std::move(elem);
+                moves += i - q;
+
+                if (moves > PARTIAL_INSERTION_SORT_LIMIT)
+                    return false;
+            }
+
+            return true;
+        }
+
+        // Searches for the first elements on the wrong sides of the pivot (arr[left_border]).
+        // Median selection guarantees element not less than pivot at the end,
+        // so the left scan is unguarded. Right scan is unguarded if some element less than pivot was found
+
+        template <typename T, typename Cmp> std::pair<std::size_t, std::size_t> find_misplaced(
+                const T* const arr,
+                const std::size_t left_border,
+                const std::size_t right_border,
+                const T& pivot,
+                const Cmp cmp
+        ) {
+            auto first = left_border, last = right_border;
+            while (cmp(arr[++first], pivot));
+
+            if (first - 1 == left_border)
+                while (first < last && !cmp(arr[--last], pivot));
+            else
+                while (!cmp(arr[--last], pivot));
+
+            return { first, last };
+        }
+
+        // Partitions range around arr[left_border], elements equal to the pivot go to the right.
+        // Returns position of the pivot and whether the range was already partitioned
+
+        template <typename T, typename Cmp> std::pair<std::size_t, bool> partition_right(
+                T* const arr,
+                const std::size_t left_border,
+                const std::size_t right_border,
+                const Cmp cmp
+        ) {
+            T pivot = std::move(arr[left_border]);
+            auto [first, last] = find_misplaced(arr, left_border, right_border, pivot, cmp);
+            const bool already_partitioned = first >= last;
+
+            while (first < last) {
+                std::swap(arr[first], arr[last]);
+                while (cmp(arr[++first], pivot));
+                while (!cmp(arr[--last], pivot));
+            }
+
+            const auto pivot_pos = first - 1;
+            arr[left_border] = std::move(arr[pivot_pos]);
+            arr[pivot_pos] = std::move(pivot);
+            return { pivot_pos, already_partitioned };
+        }
+
+        // Swaps num misplaced elements found by the blocks. If counts differ,
+        // elements are rotated through a single temporary (cycle) instead of swaps
+
+        template <typename T> void swap_offsets(
+                T* const left_base,
+                T* const right_base,
+                const unsigned char* const left_offsets,
+                const unsigned char* const right_offsets,
+                const std::size_t num,
+                const bool use_swaps
+        ) {
+            if (use_swaps) {
+                // Needed for the descending input, otherwise pivot is not balanced anymore
+                for (std::size_t i = 0; i < num; ++i)
+                    std::swap(left_base[left_offsets[i]], *(right_base - right_offsets[i]));
+
+                return;
+            }
+
+            if (num == 0)
+                return;
+
+            auto* left = left_base + left_offsets[0];
+            auto* right = right_base - right_offsets[0];
+            T tmp = std::move(*left);
+            *left = std::move(*right);
+
+            for (std::size_t i = 1; i < num; ++i) {
+                left = left_base + left_offsets[i];
+                *right = std::move(*left);
+                right = right_base - right_offsets[i];
+                *left = std::move(*right);
+            }
+
+            *right = std::move(tmp);
+        }
+
+        // Same as partition_right, but misplaced elements are found in blocks of BLOCK_SIZE
+        // without branches: offset is always written, counter is incremented by the comparison result
+        // (BlockQuicksort by Edelkamp and Weiss). Only profitable for cheap comparisons
+
+        template <typename T, typename Cmp> std::pair<std::size_t, bool> partition_right_branchless(
+                T* const arr,
+                const std::size_t left_border,
+                const std::size_t right_border,
+                const Cmp cmp
+        ) {
+            T pivot = std::move(arr[left_border]);
+            auto [first, last] = find_misplaced(arr, left_border, right_border, pivot, cmp);
+            const bool already_partitioned = first >= last;
+
+            if (!already_partitioned) {
+                std::swap(arr[first], arr[last]);
+                ++first;
+
+                alignas(64) unsigned char left_offsets[BLOCK_SIZE];
+                alignas(64) unsigned char right_offsets[BLOCK_SIZE];
+
+                auto* left_base = arr + first;
+                auto* right_base = arr + last;
+                std::size_t left_num = 0, right_num = 0, left_start = 0, right_start = 0;
+
+                while (first < last) {
+                    // Blocks are filled only when the previous ones are exhausted.
+                    // Remaining unknown elements are split between the blocks
+                    const auto unknown = last - first;
+                    const auto left_split = left_num == 0 ? (right_num == 0 ? unknown / 2 : unknown) : 0;
+                    const auto right_split = right_num == 0 ? unknown - left_split : 0;
+
+                    for (std::size_t i = 0, end = std::min(left_split, BLOCK_SIZE); i < end; ++i) {
+                        left_offsets[left_num] = static_cast<unsigned char>(i);
+                        left_num += !cmp(arr[first++], pivot);
+                    }
+
+                    for (std::size_t i = 0, end = std::min(right_split, BLOCK_SIZE); i < end;) {
+                        right_offsets[right_num] = static_cast<unsigned char>(++i);
+                        right_num += cmp(arr[--last], pivot);
+                    }
+
+                    const auto num = std::min(left_num, right_num);
+
+                    swap_offsets(
+                            left_base, right_base,
+                            left_offsets + left_start, right_offsets + right_start,
+                            num, left_num == right_num
+                    );
+
+                    left_num -= num;
+                    right_num -= num;
+                    left_start += num;
+                    right_start += num;
+
+                    if (left_num == 0) {
+                        left_start = 0;
+                        left_base = arr + first;
+                    }
+
+                    if (right_num == 0) {
+                        right_start = 0;
+                        right_base = arr + last;
+                    }
+                }
+
+                // One of the blocks may still have misplaced elements, they are moved to the border
+
+                if (left_num != 0) {
+                    while (left_num--)
+                        std::swap(left_base[left_offsets[left_start + left_num]], arr[--last]);
+
+                    first = last;
+                }
 
-        const auto mid = (left_border + right_border) >> 1;
+                if (right_num != 0) {
+                    while (right_num--)
+                        std::swap(*(right_base - right_offsets[right_start + right_num]), arr[first++]);
 
-        merge_sort(arr, left_border, mid, cmp);
-        merge_sort(arr, mid + 1, right_border, cmp);
+                    last = first;
+                }
+            }
+
+            const auto pivot_pos = first - 1;
+            arr[left_border] = std::move(arr[pivot_pos]);
+            arr[pivot_pos] = std::move(pivot);
+            return { pivot_pos, already_partitioned };
+        }
 
-        auto* const sort_holder = reinterpret_cast<T* const>(std::malloc(right_border * sizeof(T) + 1));
+        // Partitions range around arr[left_border], elements equal to the pivot go to the left.
+        // Used when the pivot equals to the previous one, so all of them are already in place
 
-        const auto holder_len = right_border - left_border + 1;
-        const void* const out_of_holder_ptr = sort_holder + holder_len;
-        auto i = left_border, q = mid + 1;
+        template <typename T, typename Cmp> std::size_t partition_left(
+                T* const arr,
+                const std::size_t left_border,
+                const std::size_t right_border,
+                const Cmp cmp
+        ) {
+            T pivot = std::move(arr[left_border]);
+            auto first = left_border, last = right_border;
+            while (cmp(pivot, arr[--last]));
 
-        for (auto* holder_elem = sort_holder; holder_elem != out_of_holder_ptr; ++holder_elem) {
-            const auto i_elem = arr[i];
-            const auto q_elem = arr[q];
+            if (last + 1 == right_border)
+                while (first < last && !cmp(pivot, arr[++first]));
+            else
+                while (!cmp(pivot, arr[++first]));
 
-            if (q > right_border || i <= mid && cmp(i_elem, q_elem)) {
-                *holder_elem = i_elem;
-                i++;
-            } else {
-                *holder_elem = q_elem;
-                q++;
+            while (first < last) {
+                std::swap(arr[first], arr[last]);
+                while (cmp(pivot, arr[--last]));
+                while (!cmp(pivot, arr[++first]));
             }
+
+            arr[left_border] = std::move(arr[last]);
+            arr[last] = std::move(pivot);
+            return last;
         }
 
-        for (int step = 0; step < right_border - left_border + 1; step++)
-            arr[left_border + step] = sort_holder[step];
+        template <bool BRANCHLESS, typename T, typename Cmp> void sort(
+                T* const arr,
+                std::size_t left_border,
+                const std::size_t right_border,
+                const Cmp cmp,
+                std::size_t bad_allowed,
+                bool leftmost
+        ) {
+            while (true) {
+                const auto size = right_border - left_border;
+
+                if (size < INSERTION_SORT_THRESHOLD) {
+                    insertion_sort(arr, left_border, right_border, cmp);
+                    return;
+                }
+
+                // Pivot is moved to arr[left_border]
+                const auto mid = left_border + size / 2;
+
+                if (size > NINTHER_THRESHOLD) {
+                    sort3(arr + left_border, arr + mid, arr + right_border - 1, cmp);
+                    sort3(arr + left_border + 1, arr + mid - 1, arr + right_border - 2, cmp);
+                    sort3(arr + left_border + 2, arr + mid + 1, arr + right_border - 3, cmp);
+                    sort3(arr + mid - 1, arr + mid, arr + mid + 1, cmp);
+                    std::swap(arr[left_border], arr[mid]);
+                } else {
+                    sort3(arr + mid, arr + left_border, arr + right_border - 1, cmp);
+                }
+
+                // Predecessor is the pivot of some parent partition, so it is not greater than any element here.
+                // If it is equal to the new pivot, all elements equal to them are skipped at once
+                if (!leftmost && !cmp(arr[left_border - 1], arr[left_border])) {
+                    left_border = partition_left(arr, left_border, right_border, cmp) + 1;
+                    continue;
+                }
+
+                const auto [pivot_pos, already_partitioned] = BRANCHLESS
+                        ? partition_right_branchless(arr, left_border, right_border, cmp)
+                        : partition_right(arr, left_border, right_border, cmp);
+
+                const auto left_size = pivot_pos - left_border;
+                const auto right_size = right_border - pivot_pos - 1;
+
+                if (left_size < size / 8 || right_size < size / 8) {
+                    // Too many bad partitions, O(n * log(n)) is guaranteed with heap sort
+                    if (--bad_allowed == 0) {
+                        std::make_heap(arr + left_border, arr + right_border, cmp);
+                        std::sort_heap(arr + left_border, arr + right_border, cmp);
+                        return;
+                    }
+
+                    // Some elements are shuffled to break the pattern that caused the bad partition
+
+                    if (left_size >= INSERTION_SORT_THRESHOLD) {
+                        const auto quarter = left_size / 4;
+                        std::swap(arr[left_border], arr[left_border + quarter]);
+                        std::swap(arr[pivot_pos - 1], arr[pivot_pos - quarter]);
+
+                        if (left_size > NINTHER_THRESHOLD) {
+                            std::swap(arr[left_border + 1], arr[left_border + quarter + 1]);
+                            std::swap(arr[left_border + 2], arr[left_border + quarter + 2]);
+                            std::swap(arr[pivot_pos - 2], arr[pivot_pos - quarter - 1]);
+                            std::swap(arr[pivot_pos - 3], arr[pivot_pos - quarter - 2]);
+                        }
+                    }
+
+                    if (right_size >= INSERTION_SORT_THRESHOLD) {
+                        const auto quarter = right_size / 4;
+                        std::swap(arr[pivot_pos + 1], arr[pivot_pos + quarter + 1]);
+                        std::swap(arr[right_border - 1], arr[right_border - quarter]);
+
+                        if (right_size > NINTHER_THRESHOLD) {
+                            std::swap(arr[pivot_pos + 2], arr[pivot_pos + quarter + 2]);
+                            std::swap(arr[pivot_pos + 3], arr[pivot_pos + quarter + 3]);
+                            std::swap(arr[right_border - 2], arr[right_border - quarter - 1]);
+                            std::swap(arr[right_border - 3], arr[right_border - quarter - 2]);
+                        }
+                    }
+                } else if (
+                        already_partitioned &&
+                        partial_insertion_sort(arr, left_border, pivot_pos, cmp) &&
+                        partial_insertion_sort(arr, pivot_pos + 1, right_border, cmp)
+                ) {
+                    // No swaps were made by partition, so the range is probably sorted
+                    return;
+                }
+
+                sort<BRANCHLESS>(arr, left_border, pivot_pos, cmp, bad_allowed, leftmost);
+                left_border = pivot_pos + 1;
+                leftmost = false;
+            }
+        }
 
-        std::free(sort_holder);
+        // Branchless partition is used for arithmetic types compared with standard comparators
+        template <typename T, typename Cmp> constexpr bool IS_BRANCHLESS_PARTITIONABLE =
+                std::is_arithmetic_v<T> && (std::is_same_v<Cmp, std::less<T>> || std::is_same_v<Cmp, std::greater<T>>);
     }
 }
 
-template <typename T, typename Cmp> auto merge_sort(
+// In-place unstable sort (pattern-defeating quicksort): quicksort with median of 3 or ninther pivot,
+// partitions without swaps are checked with partial insertion sort, so sorted inputs take O(n),
+// runs of elements equal to the previous pivot are skipped in O(n).
+// After log(n) highly unbalanced partitions range is sorted with heap sort, so worst case is O(n * log(n)).
+// No extra memory is required, unlike merge sort
+
+template <typename T, typename Cmp> auto unstable_sort(
         T* const arr,
         const std::size_t size,
         const Cmp cmp
-) { merge_sort(arr, 0, size - 1, cmp); }
+) {
+    if (size < 2)
+        return;
+
+    pdq::sort<pdq::IS_BRANCHLESS_PARTITIONABLE<T, Cmp>>(arr, 0, size, cmp, std::bit_width(size), true);
+}
+
+// Parameters of the external sort. Peak memory is about
+// (run_size + fan_in * buffer_size) * sizeof(int) bytes
+
+struct external_sort_config {
+    // Number of ints sorted in memory and spilled as one run
+    std::size_t run_size = 1 << 24;
+
+    // Number of runs merged at once. If there are more runs, they are merged in several passes
+    std::size_t fan_in = 64;
+
+    // Number of ints read from (or written to) run file at once
+    std::size_t buffer_size = 1 << 16;
+};
+
+namespace {
+    // Sorted run stored in the spill file
+    struct run {
+        long long offset;
+        std::size_t size;
+    };
+
+    // Sequential reader of the binary run through the buffer.
+    // All runs of the pass share the same file, so reader seeks before every refill
+
+    struct run_reader {
+        std::FILE* file = nullptr;
+        long long offset = 0;
+        std::size_t remaining = 0;
+
+        int* buffer = nullptr;
+        std::size_t capacity = 0;
+        std::size_t size = 0;
+        std::size_t pos = 0;
+
+        int head = 0;
+        bool is_exhausted = false;
+
+        // @return false if the buffer can't be allocated
+
+        bool open(std::FILE* const spill, const run& r, const std::size_t buffer_size) {
+            file = spill;
+            offset = r.offset;
+            remaining = r.size;
+            capacity = std::min(buffer_size, std::max<std::size_t>(r.size, 1));
+            buffer = reinterpret_cast<int*>(std::malloc(capacity * sizeof(int)));
+
+            if (buffer == nullptr)
+                return false;
+
+            advance();
+            return true;
+        }
+
+        void close() { std::free(buffer); }
+
+        void advance() {
+            if (pos == size) {
+                std::fseek(file, offset, SEEK_SET);
+                size = std::fread(buffer, sizeof(int), std::min(capacity, remaining), file);
+                offset += size * sizeof(int);
+                remaining -= size;
+                pos = 0;
+            }
+
+            if (size == 0) {
+                is_exhausted = true;
+                return;
+            }
+
+            head = buffer[pos++];
+        }
+    };
+
+    // Writer of the binary runs to the end of the spill file through the buffer
+
+    struct run_writer {
+        std::FILE* file = nullptr;
+        int* buffer = nullptr;
+        std::size_t capacity = 0;
+        std::size_t size = 0;
+        std::size_t written = 0;
+
+        run_writer(std::FILE* const spill, const std::size_t buffer_size) :
+                file(spill), buffer(reinterpret_cast<int*>(std::malloc(buffer_size * sizeof(int)))), capacity(buffer_size) {}
+
+        ~run_writer() {
+            flush();
+            std::free(buffer);
+        }
+
+        bool is_valid() const { return buffer != nullptr; }
+
+        void operator()(const int value) {
+            if (size == capacity)
+                flush();
+
+            buffer[size++] = value;
+            ++written;
+        }
+
+        void flush() {
+            std::fwrite(buffer, sizeof(int), size, file);
+            size = 0;
+        }
+    };
+
+    // Loser tree over k runs. Leaves are nodes [k, 2k), every internal node
+    // keeps the run that lost the match in it, tree[0] keeps the overall winner.
+    // After the winner is advanced, only matches on its path are replayed,
+    // so every element costs log(k) comparisons.
+    // Winners of the initial matches are kept after the tree in the same allocation
+
+    class loser_tree {
+        run_reader* runs;
+        std::size_t k;
+        std::size_t* tree;
+
+        bool wins(const std::size_t a, const std::size_t b) const {
+            if (runs[a].is_exhausted)
+                return false;
+
+            if (runs[b].is_exhausted)
+                return true;
+
+            return runs[a].head < runs[b].head || (runs[a].head == runs[b].head && a < b);
+        }
+
+    public:
+        loser_tree(run_reader* const runs, const std::size_t k) :
+                runs(runs), k(k), tree(reinterpret_cast<std::size_t*>(std::malloc(3 * k * sizeof(std::size_t)))) {
+            if (tree == nullptr)
+                return;
+
+            auto* const winners = tree + k;
+
+            for (std::size_t i = 0; i < k; ++i)
+                winners[k + i] = i;
+
+            for (auto node = k - 1; node > 0; --node) {
+                const auto left = winners[2 * node];
+                const auto right = winners[2 * node + 1];
+                const auto is_right_winner = wins(right, left);
+
+                winners[node] = is_right_winner ? right : left;
+                tree[node] = is_right_winner ? left : right;
+            }
+
+            tree[0] = k == 1 ? 0 : winners[1];
+        }
+
+        ~loser_tree() { std::free(tree); }
+
+        bool is_valid() const { return tree != nullptr; }
+
+        bool is_empty() const { return runs[tree[0]].is_exhausted; }
+
+        int pop() {
+            auto winner = tree[0];
+            const auto value = runs[winner].head;
+            runs[winner].advance();
+
+            for (auto node = (winner + k) / 2; node > 0; node /= 2)
+                if (wins(tree[node], winner))
+                    std::swap(tree[node], winner);
+
+            tree[0] = winner;
+            return value;
+        }
+    };
+
+    // Merges runs from the spill file with the loser tree, every int is passed to emit
+    // @return false if buffers can't be allocated
+
+    template <typename Emit> bool merge_runs(
+            std::FILE* const spill,
+            const run* const runs,
+            const std::size_t runs_number,
+            const std::size_t buffer_size,
+            Emit& emit
+    ) {
+        auto* const readers = new (std::nothrow) run_reader[runs_number];
+
+        if (readers == nullptr)
+            return false;
+
+        bool is_opened = true;
+
+        for (std::size_t i = 0; i < runs_number && is_opened; ++i)
+            is_opened = readers[i].open(spill, runs[i], buffer_size);
+
+        if (is_opened) {
+            loser_tree tree(readers, runs_number);
+            is_opened = tree.is_valid();
+
+            while (is_opened && !tree.is_empty())
+                emit(tree.pop());
+        }
+
+        for (std::size_t i = 0; i < runs_number; ++i)
+            readers[i].close();
+
+        delete[] readers;
+        return is_opened;
+    }
+}
+
+// Sorts ints from the input file (count, then ints, as in stdin) that may not fit into memory.
+// Input is split into runs of config.run_size, which are sorted in place with unstable_sort
+// (no scratch buffer, ints don't need stability) and spilled to the temporary file.
+// Runs are merged by config.fan_in at a time with the loser tree into the next temporary file
+// until at most fan_in of them are left, the last merge writes result to the output file.
+// Complexity is O(n * log(n)) comparisons and O(n * log_fan_in(n / run_size)) I/O
+// @return false if files can't be opened or buffers can't be allocated
+
+bool external_sort(const char* const input_path, const char* const output_path, const external_sort_config& config) {
+    auto* const input = std::fopen(input_path, "r");
+
+    if (input == nullptr)
+        return false;
+
+    auto* const output = std::fopen(output_path, "w");
+    auto* spill = std::tmpfile();
+
+    if (output == nullptr || spill == nullptr) {
+        std::fclose(input);
+
+        if (output != nullptr)
+            std::fclose(output);
+
+        return false;
+    }
+
+    const auto fan_in = std::max<std::size_t>(config.fan_in, 2);
+    const auto run_size = std::max<std::size_t>(config.run_size, 1);
+    const auto buffer_size = std::max<std::size_t>(config.buffer_size, 1);
+    std::size_t runs_number = 0;
+    std::size_t runs_capacity = fan_in;
+    auto* runs = reinterpret_cast<run*>(std::malloc(runs_capacity * sizeof(run)));
+
+    // Generating sorted runs
+
+    long long n = 0;
+    std::fscanf(input, "%lld", &n);
+
+    auto* const run_buffer = reinterpret_cast<int*>(std::malloc(run_size * sizeof(int)));
+    long long offset = 0;
+    bool is_sorted = runs != nullptr && run_buffer != nullptr;
+
+    while (is_sorted && n > 0) {
+        std::size_t size = 0;
+
+        while (size < run_size && n > 0 && std::fscanf(input, "%d", run_buffer + size) == 1) {
+            ++size;
+            --n;
+        }
+
+        if (size == 0)
+            break;
+
+        unstable_sort(run_buffer, size, std::less<int>());
+        std::fwrite(run_buffer, sizeof(int), size, spill);
+
+        if (runs_number == runs_capacity) {
+            auto* const grown = reinterpret_cast<run*>(std::realloc(runs, 2 * runs_capacity * sizeof(run)));
+
+            if (grown == nullptr) {
+                is_sorted = false;
+                break;
+            }
+
+            runs = grown;
+            runs_capacity <<= 1;
+        }
+
+        runs[runs_number++] = { offset, size };
+        offset += size * sizeof(int);
+    }
+
+    std::free(run_buffer);
+    std::fclose(input);
+
+    // Merging runs by fan_in until the last pass is left
+
+    while (is_sorted && runs_number > fan_in) {
+        auto* const merged_spill = std::tmpfile();
+
+        if (merged_spill == nullptr) {
+            is_sorted = false;
+            break;
+        }
+
+        std::size_t merged_number = 0;
+        offset = 0;
+
+        for (std::size_t first = 0; first < runs_number && is_sorted; first += fan_in) {
+            run_writer writer(merged_spill, buffer_size);
+            is_sorted = writer.is_valid() &&
+                    merge_runs(spill, runs + first, std::min(fan_in, runs_number - first), buffer_size, writer);
+
+            runs[merged_number++] = { offset, writer.written };
+            offset += writer.written * sizeof(int);
+        }
+
+        std::fclose(spill);
+        spill = merged_spill;
+        runs_number = merged_number;
+    }
+
+    auto print = [output](const int value) { std::fprintf(output, "%d ", value); };
+
+    if (is_sorted && runs_number > 0)
+        is_sorted = merge_runs(spill, runs, runs_number, buffer_size, print);
+
+    std::free(runs);
+    std::fclose(spill);
+    std::fclose(output);
+    return is_sorted;
+}
+
+// With arguments `input output [run_size] [fan_in]` file is sorted with external sort,
+// otherwise ints are read from stdin
+
+int main(int argc, char** argv) {
+    if (argc >= 3) {
+        external_sort_config config;
+
+        if (argc >= 4)
+            config.run_size = std::max(std::strtoull(argv[3], nullptr, 10), 1ULL);
+
+        if (argc >= 5)
+            config.fan_in = std::strtoull(argv[4], nullptr, 10);
+
+        return external_sort(argv[1], argv[2], config) ? 0 : 1;
+    }
 
-int main() {
     int n = 0;
     std::scanf("%d", &n);
 
     int* const arr = reinterpret_cast<int* const>(std::malloc(n * sizeof(int)));
 
+    if (arr == nullptr)
+        return 1;
+
     for (int* i = arr; i != arr + n; ++i)
         std::scanf("%d", i);
 
-    merge_sort(arr, n, [](const int a, const int b) { return a < b; });
+    // Ints don't need stability, so without memory for merge sort they are sorted in place
+    if (!merge_sort(arr, n, std::less<int>()))
+        unstable_sort(arr, n, std::less<int>());
 
     for (int* i = arr; i != arr + n; ++i)
         std::printf("%d ", *i);
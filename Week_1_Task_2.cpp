@@ -5,57 +5,78 @@
 #include <string>
 #include <sstream>
 #include <algorithm>
+#include <vector>
+#include <utility>
+
+// Streaming selection of the k best elements with a bounded heap.
+// Element a is better than b if cmp(a, b), equal elements keep their input order
+// (same as the stable sort gives). The worst of the kept elements is on top of the heap,
+// so new element is either rejected with a single comparison or replaces it.
+// Complexity is O(n * log(k)) time and O(min(n, k)) memory
+
+template <typename T, typename Cmp> class top_k {
+    struct entry {
+        T value;
+        std::size_t index;
+    };
+
+    std::size_t k;
+    std::size_t pushed = 0;
+    std::vector<entry> heap;
+    Cmp cmp;
+
+    bool precedes(const T& a, const std::size_t a_index, const T& b, const std::size_t b_index) const {
+        if (cmp(a, b))
+            return true;
+
+        if (cmp(b, a))
+            return false;
+
+        return a_index < b_index;
+    }
 
-namespace {
-    template <typename T, typename Cmp> auto merge_sort(
-            T* const arr,
-            const std::size_t left_border,
-            const std::size_t right_border,
-            const Cmp cmp
-    ) {
-        if (left_border + 1 >= right_border)
-            return;
-
-        const auto mid = (left_border + right_border) >> 1;
+    auto heap_cmp() const {
+        return [this](const entry& a, const entry& b) { return precedes(a.value, a.index, b.value, b.index); };
+    }
 
-        merge_sort(arr, left_border, mid, cmp);
-        merge_sort(arr, mid, right_border, cmp);
+public:
+    // Heap grows with the input, so huge k with few elements doesn't allocate k entries
+    top_k(const std::size_t k, const Cmp cmp) : k(k), cmp(cmp) {}
+    ~top_k() = default;
 
-        int i = 0, q = 0;
-        auto* const sort_holder = new T[right_border - left_border];
+    void push(T&& value) {
+        const auto index = pushed++;
 
-        while (left_border + i < mid && mid + q < right_border) {
-            if (cmp(arr[left_border + i], arr[mid + q])) {
-                sort_holder[i + q] = arr[left_border + i];
-                ++i;
-            } else {
-                sort_holder[i + q] = arr[mid + q];
-                ++q;
-            }
+        if (heap.size() < k) {
+            heap.push_back({ std::move(value), index });
+            std::push_heap(heap.begin(), heap.end(), heap_cmp());
+            return;
         }
 
-        while (left_border + i < mid) {
-            sort_holder[i + q] = arr[left_border + i];
-            ++i;
-        }
+        if (k == 0 || !precedes(value, index, heap.front().value, heap.front().index))
+            return;
 
-        while (mid + q < right_border) {
-            sort_holder[i + q] = arr[mid + q];
-            ++q;
-        }
+        std::pop_heap(heap.begin(), heap.end(), heap_cmp());
+        heap.back() = { std::move(value), index };
+        std::push_heap(heap.begin(), heap.end(), heap_cmp());
+    }
 
-        for (int step = 0; step < i + q; ++step)
-            arr[left_border + step] = sort_holder[step];
+    void push(const T& value) { push(T(value)); }
 
-        delete[] sort_holder;
-    }
-}
+    // Moves kept elements out from the best to the worst one
+    std::vector<T> take() {
+        std::sort_heap(heap.begin(), heap.end(), heap_cmp());
+
+        std::vector<T> result;
+        result.reserve(heap.size());
 
-template <typename T, typename Cmp> auto merge_sort(
-        T* const arr,
-        const std::size_t size,
-        const Cmp cmp
-) { merge_sort(arr, 0, size, cmp); }
+        for (auto& [value, index] : heap)
+            result.push_back(std::move(value));
+
+        heap.clear();
+        return result;
+    }
+};
 
 class player {
     std::string name;
@@ -78,9 +99,12 @@ int main() {
     int n = 0, k = 0;
     std::cin >> n >> k;
 
-    auto* const players = new player[n];
+    const auto by_score = [](const player& a, const player& b) { return a.get_score() > b.get_score(); };
+
+    // Only k best players are kept while reading
+    top_k<player, decltype(by_score)> best_players(std::max(k, 0), by_score);
 
-    for (auto* p = players; p != players + n; ++p) {
+    for (int i = 0; i < n; ++i) {
         std::string input;
         std::getline(std::cin >> std::ws, input);
         std::stringstream s;
@@ -88,16 +112,11 @@ int main() {
 
         std::string name; std::uint64_t score;
         s >> name >> score;
-        *p = player(std::move(name), score);
+        best_players.push(player(std::move(name), score));
     }
 
-    merge_sort(players, n, [](const auto& a, const auto& b) { return a.get_score() >= b.get_score(); });
-
-    const auto bound = std::min(n, k);
-
-    for (auto* i = players; i != players + bound; ++i)
-        std::cout << i->get_name() << ' ' << i->get_score() << std::endl;
+    for (const auto& p : best_players.take())
+        std::cout << p.get_name() << ' ' << p.get_score() << std::endl;
 
-    delete[] players;
     return 0;
 }
@@ -2,15 +2,20 @@
 
 #include <memory>
 #include <iostream>
-#include <sstream>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
 
 template <typename T> struct stack {
     virtual std::size_t get_size() const = 0;
     virtual bool is_empty() const = 0;
     virtual void push(T&& elem) = 0;
-    virtual void push(T elem) = 0;
-    virtual std::shared_ptr<T> pop() = 0;
-    virtual std::shared_ptr<T> get_last() const = 0;
+    virtual void push(const T& elem) = 0;
+    virtual T pop() = 0;
+    virtual const T& get_last() const = 0;
 };
 
 template <typename T> class linked_stack : public stack<T> {
@@ -44,26 +49,103 @@ public:
     }
 
     void push(T&& item) override {
-        stack_node node(std::make_shared<T>(item), last);
+        stack_node node(std::make_shared<T>(std::move(item)), last);
         last = std::make_shared<stack_node>(node);
         ++size;
     }
 
-    void push(T item) override {
+    void push(const T& item) override {
         stack_node node(std::make_shared<T>(item), last);
         last = std::make_shared<stack_node>(node);
         ++size;
     }
 
-    std::shared_ptr<T> pop() override {
+    T pop() override {
         --size;
         const auto removed = last;
         last = removed->prev;
-        return removed->item;
+        return std::move(*removed->item);
     }
 
-    std::shared_ptr<T> get_last() const override {
-        return last->item;
+    const T& get_last() const override {
+        return *last->item;
+    }
+};
+
+// Stack in a contiguous buffer which grows twice when it is full,
+// so push is amortized O(1) without allocation per element.
+// Elements are constructed in uninitialized storage,
+// so T doesn't need to be default-constructible
+
+template <typename T> class array_stack final : public stack<T> {
+    static constexpr std::size_t INITIAL_CAPACITY = 16;
+
+    std::size_t size = 0;
+    std::size_t capacity = 0;
+    T* data = nullptr;
+
+    void reallocate(const std::size_t new_capacity) {
+        auto* const new_data = std::allocator<T>().allocate(new_capacity);
+        std::uninitialized_move(data, data + size, new_data);
+        std::destroy(data, data + size);
+
+        if (data != nullptr)
+            std::allocator<T>().deallocate(data, capacity);
+
+        data = new_data;
+        capacity = new_capacity;
+    }
+
+public:
+    array_stack() = default;
+
+    explicit array_stack(const std::size_t capacity) { reserve(capacity); }
+
+    array_stack(const array_stack&) = delete;
+    array_stack& operator=(const array_stack&) = delete;
+
+    ~array_stack() {
+        std::destroy(data, data + size);
+
+        if (data != nullptr)
+            std::allocator<T>().deallocate(data, capacity);
+    }
+
+    void reserve(const std::size_t new_capacity) {
+        if (new_capacity > capacity)
+            reallocate(new_capacity);
+    }
+
+    std::size_t get_size() const override {
+        return size;
+    }
+
+    bool is_empty() const override {
+        return size == 0;
+    }
+
+    void push(T&& item) override {
+        if (size == capacity)
+            reallocate(capacity == 0 ? INITIAL_CAPACITY : capacity * 2);
+
+        std::construct_at(data + size, std::move(item));
+        ++size;
+    }
+
+    void push(const T& item) override {
+        // Copy is made before reallocation, item may be an element of this stack
+        push(T(item));
+    }
+
+    T pop() override {
+        --size;
+        T item = std::move(data[size]);
+        std::destroy_at(data + size);
+        return item;
+    }
+
+    const T& get_last() const override {
+        return data[size - 1];
     }
 };
 
@@ -77,82 +159,266 @@ namespace {
     const int COMMA_PRIORITY = -1;
     const int BRACE_PRIORITY = -2;
 
+    enum class opcode { MINUS, PLUS, MUL, DIV, MIN, MAX, OPEN_BRACE, CLOSE_BRACE, COMMA };
+
+    // Operator is mapped to the opcode once when it is parsed,
+    // then it is dispatched with switch instead of string comparisons
+
     class operation {
-        std::string value;
+        opcode code;
         int priority;
 
-        operation(std::string&& value, const int priority) {
-            this->value = value;
-            this->priority = priority;
-        }
+        operation(const opcode code, const int priority) : code(code), priority(priority) {}
 
     public:
         ~operation() = default;
 
-        const std::string& get_value() const { return value; }
+        opcode get_opcode() const { return code; }
         int get_priority() const { return priority; }
 
-        static operation parse(const std::string& value) {
-            if (value == "-") return operation("-", MINUS_PRIORITY);
-            if (value == "+") return operation("+", PLUS_PRIORITY);
-            if (value == "*") return operation("*", MUL_PRIORITY);
-            if (value == "/") return operation("/", DIV_PRIORITY);
-            if (value == "min") return operation("min", MIN_PRIORITY);
-            if (value == "max") return operation("max", MAX_PRIORITY);
-            if (value == "(") return operation("(", BRACE_PRIORITY);
-            if (value == ")") return operation(")", BRACE_PRIORITY);
-            if (value == ",") return operation(",", COMMA_PRIORITY);
+        std::string_view get_value() const {
+            return get_name(code);
+        }
+
+        static std::string_view get_name(const opcode code) {
+            switch (code) {
+                case opcode::MINUS: return "-";
+                case opcode::PLUS: return "+";
+                case opcode::MUL: return "*";
+                case opcode::DIV: return "/";
+                case opcode::MIN: return "min";
+                case opcode::MAX: return "max";
+                case opcode::OPEN_BRACE: return "(";
+                case opcode::CLOSE_BRACE: return ")";
+                case opcode::COMMA: return ",";
+            }
+
+            throw std::runtime_error("Unknown operator");
+        }
+
+        static operation parse(const std::string_view value) {
+            if (value.size() == 1) {
+                switch (value[0]) {
+                    case '-': return operation(opcode::MINUS, MINUS_PRIORITY);
+                    case '+': return operation(opcode::PLUS, PLUS_PRIORITY);
+                    case '*': return operation(opcode::MUL, MUL_PRIORITY);
+                    case '/': return operation(opcode::DIV, DIV_PRIORITY);
+                    case '(': return operation(opcode::OPEN_BRACE, BRACE_PRIORITY);
+                    case ')': return operation(opcode::CLOSE_BRACE, BRACE_PRIORITY);
+                    case ',': return operation(opcode::COMMA, COMMA_PRIORITY);
+                    default: break;
+                }
+            }
+
+            if (value == "min") return operation(opcode::MIN, MIN_PRIORITY);
+            if (value == "max") return operation(opcode::MAX, MAX_PRIORITY);
             throw std::runtime_error("Unknown operator");
         }
     };
 
-    inline bool is_digit(const std::string& s) {
-        return s[0] >= '0' && s[0] <= '9';
+    inline bool is_digit(const char c) {
+        return c >= '0' && c <= '9';
     }
-}
 
-int main() {
-    linked_stack<operation> operations;
+    inline bool is_letter(const char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    inline bool is_identifier_start(const char c) {
+        return is_letter(c) || c == '_';
+    }
+
+    inline bool is_space(const char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    // Whether c continues the token which starts with first, operators always have single char
+    inline bool continues_token(const char first, const char c) {
+        if (is_digit(first))
+            return is_digit(c);
+
+        if (is_identifier_start(first))
+            return is_identifier_start(c) || is_digit(c);
+
+        return false;
+    }
 
-    std::string whole_input;
-    std::getline(std::cin, whole_input);
+    // Splits the first line of the stream into numbers, words (min, max and variables)
+    // and single-char operators. Line is read by chunks of CHUNK_SIZE,
+    // so the whole input is never kept in memory. Token which crosses the border of chunks
+    // is collected into the carry buffer. Token is valid until the next call.
+    // Memory is O(CHUNK_SIZE + length of the longest token)
 
-    std::stringstream ss(whole_input);
-    std::string input;
+    class chunked_lexer {
+        static constexpr std::size_t CHUNK_SIZE = 1 << 16;
 
-    while (ss >> input) {
-        if (is_digit(input)) {
-            std::cout << input << ' ';
-        } else {
-            const auto sign = operation::parse(input);
+        std::istream& input;
+        std::vector<char> chunk = std::vector<char>(CHUNK_SIZE);
+        std::size_t pos = 0;
+        std::size_t size = 0;
+        bool is_line_end = false;
+        std::string carry;
 
-            if (sign.get_value() == ",") {
-                while (operations.get_last()->get_value() != "(")
-                    std::cout << operations.pop()->get_value() << ' ';
-            } else if (sign.get_value() == ")") {
-                while (operations.get_last()->get_value() != "(")
-                    std::cout << operations.pop()->get_value() << ' ';
+        bool refill() {
+            if (is_line_end)
+                return false;
+
+            input.read(chunk.data(), static_cast<std::streamsize>(CHUNK_SIZE));
+            size = static_cast<std::size_t>(input.gcount());
+            pos = 0;
+
+            const auto* const line_end = std::find(chunk.data(), chunk.data() + size, '\n');
+
+            if (line_end != chunk.data() + size || size < CHUNK_SIZE) {
+                size = line_end - chunk.data();
+                is_line_end = true;
+            }
+
+            return size > 0;
+        }
+
+    public:
+        explicit chunked_lexer(std::istream& input) : input(input) {}
+
+        std::optional<std::string_view> next() {
+            while (true) {
+                while (pos < size && is_space(chunk[pos]))
+                    ++pos;
+
+                if (pos < size)
+                    break;
+
+                if (!refill())
+                    return std::nullopt;
+            }
+
+            const auto start = pos;
+            const auto first = chunk[pos++];
+
+            while (pos < size && continues_token(first, chunk[pos]))
+                ++pos;
+
+            if (pos < size || is_line_end)
+                return std::string_view(chunk.data() + start, pos - start);
+
+            // Token may continue in the next chunks
+            carry.assign(chunk.data() + start, pos - start);
+
+            while (refill()) {
+                while (pos < size && continues_token(first, chunk[pos]))
+                    ++pos;
+
+                carry.append(chunk.data(), pos);
+
+                if (pos < size)
+                    break;
+            }
+
+            return std::string_view(carry);
+        }
+    };
+
+    // Shunting-yard algorithm as a state machine: tokens are fed one by one,
+    // operands and operations are passed to the sink in RPN order as soon as they are known.
+    // Sink has on_number(token), on_variable(token) and on_operation(opcode).
+    // Memory depends only on the depth of the operations stack
+
+    template <typename Sink> class shunting_yard {
+        Sink& sink;
+        array_stack<operation> operations;
+
+        void emit_last() {
+            sink.on_operation(operations.pop().get_opcode());
+        }
+
+        bool is_before_open_brace() const {
+            if (operations.is_empty())
+                throw std::runtime_error("Unbalanced braces");
+
+            return operations.get_last().get_opcode() != opcode::OPEN_BRACE;
+        }
+
+    public:
+        explicit shunting_yard(Sink& sink) : sink(sink) {}
+
+        void feed(const std::string_view token) {
+            if (is_digit(token.front())) {
+                sink.on_number(token);
+                return;
+            }
+
+            if (is_identifier_start(token.front()) && token != "min" && token != "max") {
+                sink.on_variable(token);
+                return;
+            }
+
+            const auto sign = operation::parse(token);
+
+            if (sign.get_opcode() == opcode::COMMA) {
+                while (is_before_open_brace())
+                    emit_last();
+            } else if (sign.get_opcode() == opcode::CLOSE_BRACE) {
+                while (is_before_open_brace())
+                    emit_last();
 
                 operations.pop();
 
-                if (!operations.is_empty() && operations.get_last()->get_priority() == 2)
-                    std::cout << operations.pop()->get_value() << ' ';
-            } else if (sign.get_value() != "(") {
-                while (!operations.is_empty() && operations.get_last()->get_priority() >= sign.get_priority()) {
-                    auto sig = operations.pop()->get_value();
-                    std::cout << sig << ' ';
-                }
+                if (!operations.is_empty() && operations.get_last().get_priority() == 2)
+                    emit_last();
+            } else if (sign.get_opcode() != opcode::OPEN_BRACE) {
+                while (!operations.is_empty() && operations.get_last().get_priority() >= sign.get_priority())
+                    emit_last();
             }
 
-            if (sign.get_value() != "," && sign.get_value() != ")")
+            if (sign.get_opcode() != opcode::COMMA && sign.get_opcode() != opcode::CLOSE_BRACE)
                 operations.push(sign);
         }
-    }
 
-    while (!operations.is_empty()) {
-        const auto sig = operations.pop()->get_value();
-        std::cout << sig << ' ';
-    }
+        // Emits operations which are left after the last token
+        void finish() {
+            while (!operations.is_empty()) {
+                if (operations.get_last().get_opcode() == opcode::OPEN_BRACE)
+                    throw std::runtime_error("Unbalanced braces");
+
+                emit_last();
+            }
+        }
+    };
+
+    // Sink of shunting_yard which prints operands and operations in RPN order right away
+    class rpn_printer {
+        std::ostream& output;
+
+    public:
+        explicit rpn_printer(std::ostream& output) : output(output) {}
+
+        void on_number(const std::string_view token) {
+            output << token << ' ';
+        }
+
+        void on_variable(const std::string_view token) {
+            output << token << ' ';
+        }
+
+        void on_operation(const opcode code) {
+            output << operation::get_name(code) << ' ';
+        }
+    };
+
+}
+
+int main() {
+    std::ios_base::sync_with_stdio(false);
+
+    // Expression is converted while it is read, so memory doesn't depend on its length
+    rpn_printer printer(std::cout);
+    shunting_yard<rpn_printer> parser(printer);
+    chunked_lexer tokens(std::cin);
+
+    while (const auto token = tokens.next())
+        parser.feed(*token);
+
+    parser.finish();
 
     return 0;
 }
@@ -2,15 +2,36 @@
 
 #include <memory>
 #include <iostream>
-#include <sstream>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <stdexcept>
+#include <algorithm>
+#include <charconv>
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
+#include <map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdlib>
+#include <array>
+
+#pragma GCC target("avx,avx2,fma")
+
+#include <immintrin.h>
 
 template <typename T> struct stack {
     virtual std::size_t get_size() const = 0;
     virtual bool is_empty() const = 0;
     virtual void push(T&& elem) = 0;
-    virtual void push(T elem) = 0;
-    virtual std::shared_ptr<T> pop() = 0;
-    virtual std::shared_ptr<T> get_last() const = 0;
+    virtual void push(const T& elem) = 0;
+    virtual T pop() = 0;
+    virtual const T& get_last() const = 0;
 };
 
 template <typename T> class linked_stack : public stack<T> {
@@ -44,26 +65,151 @@ public:
     }
 
     void push(T&& item) override {
-        stack_node node(std::make_shared<T>(item), last);
+        stack_node node(std::make_shared<T>(std::move(item)), last);
         last = std::make_shared<stack_node>(node);
         ++size;
     }
 
-    void push(T item) override {
+    void push(const T& item) override {
         stack_node node(std::make_shared<T>(item), last);
         last = std::make_shared<stack_node>(node);
         ++size;
     }
 
-    std::shared_ptr<T> pop() override {
+    T pop() override {
         --size;
         const auto removed = last;
         last = removed->prev;
-        return removed->item;
+        return std::move(*removed->item);
+    }
+
+    const T& get_last() const override {
+        return *last->item;
+    }
+};
+
+// Stack in a contiguous buffer which grows twice when it is full,
+// so push is amortized O(1) without allocation per element.
+// Elements are constructed in uninitialized storage,
+// so T doesn't need to be default-constructible
+
+template <typename T> class array_stack final : public stack<T> {
+    static constexpr std::size_t INITIAL_CAPACITY = 16;
+
+    std::size_t size = 0;
+    std::size_t capacity = 0;
+    T* data = nullptr;
+
+    void reallocate(const std::size_t new_capacity) {
+        auto* const new_data = std::allocator<T>().allocate(new_capacity);
+        std::uninitialized_move(data, data + size, new_data);
+        std::destroy(data, data + size);
+
+        if (data != nullptr)
+            std::allocator<T>().deallocate(data, capacity);
+
+        data = new_data;
+        capacity = new_capacity;
+    }
+
+public:
+    array_stack() = default;
+
+    explicit array_stack(const std::size_t capacity) { reserve(capacity); }
+
+    array_stack(const array_stack&) = delete;
+    array_stack& operator=(const array_stack&) = delete;
+
+    ~array_stack() {
+        std::destroy(data, data + size);
+
+        if (data != nullptr)
+            std::allocator<T>().deallocate(data, capacity);
+    }
+
+    void reserve(const std::size_t new_capacity) {
+        if (new_capacity > capacity)
+            reallocate(new_capacity);
+    }
+
+    // Removes all elements, buffer is kept for reuse
+    void clear() {
+        std::destroy(data, data + size);
+        size = 0;
+    }
+
+    std::size_t get_size() const override {
+        return size;
+    }
+
+    bool is_empty() const override {
+        return size == 0;
+    }
+
+    void push(T&& item) override {
+        if (size == capacity)
+            reallocate(capacity == 0 ? INITIAL_CAPACITY : capacity * 2);
+
+        std::construct_at(data + size, std::move(item));
+        ++size;
+    }
+
+    void push(const T& item) override {
+        // Copy is made before reallocation, item may be an element of this stack
+        push(T(item));
+    }
+
+    T pop() override {
+        --size;
+        T item = std::move(data[size]);
+        std::destroy_at(data + size);
+        return item;
+    }
+
+    const T& get_last() const override {
+        return data[size - 1];
+    }
+};
+
+// Stack with capacity fixed at compile time, elements are kept in std::array,
+// so it can be used in constant expressions. Overflow is an error
+
+template <typename T, std::size_t N> class fixed_stack final : public stack<T> {
+    std::array<T, N> data {};
+    std::size_t size = 0;
+
+public:
+    constexpr fixed_stack() = default;
+
+    constexpr std::size_t get_size() const override {
+        return size;
+    }
+
+    constexpr bool is_empty() const override {
+        return size == 0;
+    }
+
+    constexpr void push(T&& item) override {
+        if (size == N)
+            throw std::runtime_error("Stack overflow");
+
+        data[size++] = std::move(item);
+    }
+
+    constexpr void push(const T& item) override {
+        push(T(item));
+    }
+
+    constexpr T pop() override {
+        return std::move(data[--size]);
+    }
+
+    constexpr const T& get_last() const override {
+        return data[size - 1];
     }
 
-    std::shared_ptr<T> get_last() const override {
-        return last->item;
+    constexpr void clear() {
+        size = 0;
     }
 };
 
@@ -77,102 +223,1223 @@ namespace {
     const int COMMA_PRIORITY = -1;
     const int BRACE_PRIORITY = -2;
 
+    enum class opcode { MINUS, PLUS, MUL, DIV, MIN, MAX, OPEN_BRACE, CLOSE_BRACE, COMMA };
+
+    // Division policy for integers: x / 0 == 0, min / -1 == min (wraps around),
+    // otherwise quotient is truncated toward zero. Nothing traps, so a batch never stops on bad rows
+
+    template <typename T> constexpr T divide(const T& arg1, const T& arg2) {
+        if constexpr (std::is_integral_v<T>) {
+            if (arg2 == 0)
+                return 0;
+
+            if constexpr (std::is_signed_v<T>) {
+                if (arg2 == -1)
+                    return static_cast<T>(-static_cast<std::make_unsigned_t<std::common_type_t<T, int>>>(arg1));
+            }
+        }
+
+        return arg1 / arg2;
+    }
+
+    // Operator is mapped to the opcode once when it is parsed,
+    // then it is dispatched with switch instead of string comparisons
+
     class operation {
-        std::string value;
+        opcode code;
         int priority;
 
-        operation(std::string&& value, const int priority) {
-            this->value = value;
-            this->priority = priority;
-        }
+        constexpr operation(const opcode code, const int priority) : code(code), priority(priority) {}
 
     public:
-        ~operation() = default;
-
-        const std::string& get_value() const { return value; }
-        int get_priority() const { return priority; }
-
-        static operation parse(const std::string& value) {
-            if (value == "-") return operation("-", MINUS_PRIORITY);
-            if (value == "+") return operation("+", PLUS_PRIORITY);
-            if (value == "*") return operation("*", MUL_PRIORITY);
-            if (value == "/") return operation("/", DIV_PRIORITY);
-            if (value == "min") return operation("min", MIN_PRIORITY);
-            if (value == "max") return operation("max", MAX_PRIORITY);
-            if (value == "(") return operation("(", BRACE_PRIORITY);
-            if (value == ")") return operation(")", BRACE_PRIORITY);
-            if (value == ",") return operation(",", COMMA_PRIORITY);
+        // Placeholder for fixed-capacity stacks, real operations are created with parse
+        constexpr operation() : operation(opcode::PLUS, PLUS_PRIORITY) {}
+
+        constexpr ~operation() = default;
+
+        constexpr opcode get_opcode() const { return code; }
+        constexpr int get_priority() const { return priority; }
+
+        constexpr std::string_view get_value() const {
+            return get_name(code);
+        }
+
+        static constexpr std::string_view get_name(const opcode code) {
+            switch (code) {
+                case opcode::MINUS: return "-";
+                case opcode::PLUS: return "+";
+                case opcode::MUL: return "*";
+                case opcode::DIV: return "/";
+                case opcode::MIN: return "min";
+                case opcode::MAX: return "max";
+                case opcode::OPEN_BRACE: return "(";
+                case opcode::CLOSE_BRACE: return ")";
+                case opcode::COMMA: return ",";
+            }
+
+            throw std::runtime_error("Unknown operator");
+        }
+
+        static constexpr operation parse(const std::string_view value) {
+            if (value.size() == 1) {
+                switch (value[0]) {
+                    case '-': return operation(opcode::MINUS, MINUS_PRIORITY);
+                    case '+': return operation(opcode::PLUS, PLUS_PRIORITY);
+                    case '*': return operation(opcode::MUL, MUL_PRIORITY);
+                    case '/': return operation(opcode::DIV, DIV_PRIORITY);
+                    case '(': return operation(opcode::OPEN_BRACE, BRACE_PRIORITY);
+                    case ')': return operation(opcode::CLOSE_BRACE, BRACE_PRIORITY);
+                    case ',': return operation(opcode::COMMA, COMMA_PRIORITY);
+                    default: break;
+                }
+            }
+
+            if (value == "min") return operation(opcode::MIN, MIN_PRIORITY);
+            if (value == "max") return operation(opcode::MAX, MAX_PRIORITY);
             throw std::runtime_error("Unknown operator");
         }
 
-        template<typename T> T operator()(const T& arg1, const T& arg2) {
-            if (value == "-") return arg1 - arg2;
-            if (value == "+") return arg1 + arg2;
-            if (value == "*") return arg1 * arg2;
-            if (value == "/") return arg1 / arg2;
-            if (value == "min") return std::min(arg1, arg2);
-            if (value == "max") return std::max(arg1, arg2);
-            throw std::runtime_error("Illegal operator");
+        template<typename T> constexpr T operator()(const T& arg1, const T& arg2) const {
+            return apply(code, arg1, arg2);
+        }
+
+        template<typename T> static constexpr T apply(const opcode code, const T& arg1, const T& arg2) {
+            if constexpr (std::is_integral_v<T>) {
+                // Integers wrap around on overflow, exactly as SIMD lanes do
+                using U = std::make_unsigned_t<std::common_type_t<T, int>>;
+                const auto a = static_cast<U>(arg1), b = static_cast<U>(arg2);
+
+                switch (code) {
+                    case opcode::MINUS: return static_cast<T>(a - b);
+                    case opcode::PLUS: return static_cast<T>(a + b);
+                    case opcode::MUL: return static_cast<T>(a * b);
+                    default: break;
+                }
+            }
+
+            switch (code) {
+                case opcode::MINUS: return arg1 - arg2;
+                case opcode::PLUS: return arg1 + arg2;
+                case opcode::MUL: return arg1 * arg2;
+                case opcode::DIV: return divide(arg1, arg2);
+                case opcode::MIN: return std::min(arg1, arg2);
+                case opcode::MAX: return std::max(arg1, arg2);
+                default: throw std::runtime_error("Illegal operator");
+            }
         }
     };
 
-    inline bool is_digit(const std::string& s) {
-        return s[0] >= '0' && s[0] <= '9';
+    constexpr bool is_digit(const char c) {
+        return c >= '0' && c <= '9';
     }
-}
 
-int main() {
-    linked_stack<operation> operations;
-    linked_stack<int> nums;
+    constexpr bool is_letter(const char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    constexpr bool is_identifier_start(const char c) {
+        return is_letter(c) || c == '_';
+    }
+
+    constexpr bool is_space(const char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    // Whether c continues the token which starts with first, operators always have single char
+    constexpr bool continues_token(const char first, const char c) {
+        if (is_digit(first))
+            return is_digit(c);
+
+        if (is_identifier_start(first))
+            return is_identifier_start(c) || is_digit(c);
+
+        return false;
+    }
+
+    // Splits input into numbers, words (min, max and variables) and single-char operators.
+    // Tokens are views of the input buffer, so nothing is copied
+
+    class lexer {
+        std::string_view input;
+        std::size_t pos = 0;
+
+    public:
+        constexpr explicit lexer(const std::string_view input) : input(input) {}
+
+        constexpr std::optional<std::string_view> next() {
+            while (pos < input.size() && is_space(input[pos]))
+                ++pos;
+
+            if (pos == input.size())
+                return std::nullopt;
+
+            const auto start = pos++;
+
+            while (pos < input.size() && continues_token(input[start], input[pos]))
+                ++pos;
+
+            return input.substr(start, pos - start);
+        }
+    };
+
+    // Same tokens as lexer, but the first line of the stream is read by chunks of CHUNK_SIZE,
+    // so the whole input is never kept in memory. Token which crosses the border of chunks
+    // is collected into the carry buffer. Token is valid until the next call.
+    // Memory is O(CHUNK_SIZE + length of the longest token)
+
+    class chunked_lexer {
+        static constexpr std::size_t CHUNK_SIZE = 1 << 16;
+
+        std::istream& input;
+        std::vector<char> chunk = std::vector<char>(CHUNK_SIZE);
+        std::size_t pos = 0;
+        std::size_t size = 0;
+        bool is_line_end = false;
+        std::string carry;
+
+        bool refill() {
+            if (is_line_end)
+                return false;
+
+            input.read(chunk.data(), static_cast<std::streamsize>(CHUNK_SIZE));
+            size = static_cast<std::size_t>(input.gcount());
+            pos = 0;
+
+            const auto* const line_end = std::find(chunk.data(), chunk.data() + size, '\n');
+
+            if (line_end != chunk.data() + size || size < CHUNK_SIZE) {
+                size = line_end - chunk.data();
+                is_line_end = true;
+            }
+
+            return size > 0;
+        }
+
+    public:
+        explicit chunked_lexer(std::istream& input) : input(input) {}
+
+        std::optional<std::string_view> next() {
+            while (true) {
+                while (pos < size && is_space(chunk[pos]))
+                    ++pos;
+
+                if (pos < size)
+                    break;
+
+                if (!refill())
+                    return std::nullopt;
+            }
+
+            const auto start = pos;
+            const auto first = chunk[pos++];
+
+            while (pos < size && continues_token(first, chunk[pos]))
+                ++pos;
+
+            if (pos < size || is_line_end)
+                return std::string_view(chunk.data() + start, pos - start);
+
+            // Token may continue in the next chunks
+            carry.assign(chunk.data() + start, pos - start);
+
+            while (refill()) {
+                while (pos < size && continues_token(first, chunk[pos]))
+                    ++pos;
+
+                carry.append(chunk.data(), pos);
+
+                if (pos < size)
+                    break;
+            }
+
+            return std::string_view(carry);
+        }
+    };
+
+    // Shunting-yard algorithm as a state machine: tokens are fed one by one,
+    // operands and operations are passed to the sink in RPN order as soon as they are known.
+    // Sink has on_number(token), on_variable(token) and on_operation(opcode).
+    // Memory depends only on the depth of the operations stack.
+    // Everything is constexpr, so with fixed_stack expression can be parsed at compile time
+
+    template <typename Sink, typename Stack = array_stack<operation>> class shunting_yard {
+        Sink& sink;
+        Stack operations;
+
+        constexpr void emit_last() {
+            sink.on_operation(operations.pop().get_opcode());
+        }
+
+        constexpr bool is_before_open_brace() const {
+            if (operations.is_empty())
+                throw std::runtime_error("Unbalanced braces");
+
+            return operations.get_last().get_opcode() != opcode::OPEN_BRACE;
+        }
+
+    public:
+        constexpr explicit shunting_yard(Sink& sink) : sink(sink) {}
+
+        // Prepares for the next expression, stack is reused
+        constexpr void reset() { operations.clear(); }
+
+        constexpr void feed(const std::string_view token) {
+            if (is_digit(token.front())) {
+                sink.on_number(token);
+                return;
+            }
+
+            if (is_identifier_start(token.front()) && token != "min" && token != "max") {
+                sink.on_variable(token);
+                return;
+            }
+
+            const auto sign = operation::parse(token);
+
+            if (sign.get_opcode() == opcode::COMMA) {
+                while (is_before_open_brace())
+                    emit_last();
+            } else if (sign.get_opcode() == opcode::CLOSE_BRACE) {
+                while (is_before_open_brace())
+                    emit_last();
+
+                operations.pop();
+
+                if (!operations.is_empty() && operations.get_last().get_priority() == 2)
+                    emit_last();
+            } else if (sign.get_opcode() != opcode::OPEN_BRACE) {
+                while (!operations.is_empty() && operations.get_last().get_priority() >= sign.get_priority())
+                    emit_last();
+            }
+
+            if (sign.get_opcode() != opcode::COMMA && sign.get_opcode() != opcode::CLOSE_BRACE)
+                operations.push(sign);
+        }
+
+        // Emits operations which are left after the last token
+        constexpr void finish() {
+            while (!operations.is_empty()) {
+                if (operations.get_last().get_opcode() == opcode::OPEN_BRACE)
+                    throw std::runtime_error("Unbalanced braces");
+
+                emit_last();
+            }
+        }
+    };
+
+    // Whole token must be a number which fits into T, otherwise expression is invalid
+    template <typename T> T parse_literal(const std::string_view token) {
+        T num {};
+        const auto end = token.data() + token.size();
+        const auto [ptr, ec] = std::from_chars(token.data(), end, num);
+
+        if (ec != std::errc() || ptr != end)
+            throw std::runtime_error("Invalid number");
+
+        return num;
+    }
+
+    // Sink of shunting_yard which evaluates expression without variables right away
+    template <typename T> class stack_evaluator {
+        array_stack<T> nums;
+
+    public:
+        // Prepares for the next expression, stack is reused
+        void reset() { nums.clear(); }
+
+        void on_number(const std::string_view token) {
+            nums.push(parse_literal<T>(token));
+        }
+
+        void on_variable(const std::string_view) {
+            throw std::runtime_error("Variables are not bound");
+        }
+
+        // Right operand is on the top of the stack, so it is popped first
+        void on_operation(const opcode code) {
+            if (nums.get_size() < 2)
+                throw std::runtime_error("Missing operand");
+
+            const auto rhs = nums.pop();
+            const auto lhs = nums.pop();
+            nums.push(operation::apply(code, lhs, rhs));
+        }
+
+        T get_result() const {
+            if (nums.get_size() != 1)
+                throw std::runtime_error("Expression must have exactly one result");
+
+            return nums.get_last();
+        }
+    };
+
+    // Kernels which apply one operation to whole blocks of values.
+    // 32 and 64-bit integers are processed with AVX2 (8 or 4 lanes),
+    // operations without AVX2 instructions (64-bit mul, division) and tails are scalar
+
+    namespace columnar {
+        // Rows evaluated at once, stack of blocks for a usual formula fits into L1/L2
+        constexpr std::size_t BLOCK_ROWS = 1024;
+
+        template <typename T> constexpr bool IS_SIMD_INT32 = std::is_integral_v<T> && sizeof(T) == 4;
+        template <typename T> constexpr bool IS_SIMD_INT64 = std::is_integral_v<T> && sizeof(T) == 8;
+
+        template <typename T> void apply(
+                const opcode code,
+                const T* const lhs,
+                const T* const rhs,
+                T* const out,
+                const std::size_t size
+        ) {
+            std::size_t i = 0;
+
+            if constexpr (IS_SIMD_INT32<T> || IS_SIMD_INT64<T>) {
+                constexpr std::size_t LANES = sizeof(__m256i) / sizeof(T);
+                constexpr bool IS_SIGNED = std::is_signed_v<T>;
+
+                const auto kernel = [&](const auto op) {
+                    for (; i + LANES <= size; i += LANES) {
+                        const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i));
+                        const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i));
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), op(a, b));
+                    }
+                };
+
+                if constexpr (IS_SIMD_INT32<T>) {
+                    switch (code) {
+                        case opcode::PLUS: kernel([](__m256i a, __m256i b) { return _mm256_add_epi32(a, b); }); break;
+                        case opcode::MINUS: kernel([](__m256i a, __m256i b) { return _mm256_sub_epi32(a, b); }); break;
+                        case opcode::MUL: kernel([](__m256i a, __m256i b) { return _mm256_mullo_epi32(a, b); }); break;
+
+                        case opcode::MIN:
+                            if constexpr (IS_SIGNED)
+                                kernel([](__m256i a, __m256i b) { return _mm256_min_epi32(a, b); });
+                            else
+                                kernel([](__m256i a, __m256i b) { return _mm256_min_epu32(a, b); });
+                            break;
+
+                        case opcode::MAX:
+                            if constexpr (IS_SIGNED)
+                                kernel([](__m256i a, __m256i b) { return _mm256_max_epi32(a, b); });
+                            else
+                                kernel([](__m256i a, __m256i b) { return _mm256_max_epu32(a, b); });
+                            break;
+
+                        default: break;
+                    }
+                } else {
+                    // There is only signed 64-bit comparison, unsigned values are compared with flipped sign bits
+                    const auto greater = [](const __m256i a, const __m256i b) {
+                        if constexpr (IS_SIGNED) {
+                            return _mm256_cmpgt_epi64(a, b);
+                        } else {
+                            const auto sign = _mm256_set1_epi64x(std::numeric_limits<std::int64_t>::min());
+                            return _mm256_cmpgt_epi64(_mm256_xor_si256(a, sign), _mm256_xor_si256(b, sign));
+                        }
+                    };
+
+                    switch (code) {
+                        case opcode::PLUS: kernel([](__m256i a, __m256i b) { return _mm256_add_epi64(a, b); }); break;
+                        case opcode::MINUS: kernel([](__m256i a, __m256i b) { return _mm256_sub_epi64(a, b); }); break;
+
+                        case opcode::MIN:
+                            kernel([&greater](__m256i a, __m256i b) { return _mm256_blendv_epi8(a, b, greater(a, b)); });
+                            break;
+
+                        case opcode::MAX:
+                            kernel([&greater](__m256i a, __m256i b) { return _mm256_blendv_epi8(b, a, greater(a, b)); });
+                            break;
+
+                        default: break;
+                    }
+                }
+            }
+
+            for (; i < size; ++i)
+                out[i] = operation::apply(code, lhs[i], rhs[i]);
+        }
+    }
+
+    enum class instruction_kind : std::uint8_t { CONSTANT, VARIABLE, OPERATION, STORE, LOAD };
+
+    // Instruction of the RPN program: pushes constant or variable
+    // (operand is its index) or applies operation to the two top values.
+    // Subexpressions used several times are copied to a temporary slot with STORE
+    // (top value stays on the stack) and pushed again with LOAD
+
+    struct instruction {
+        instruction_kind kind;
+        opcode code;
+        std::uint32_t operand;
+    };
+
+    // Expression with named variables compiled once into RPN bytecode,
+    // so it can be evaluated for many bindings without parsing.
+    // Program is validated while compiling, evaluation needs
+    // a preallocated stack of get_stack_size() values and doesn't check anything
+
+    template <typename T> class expression_dag;
+
+    template <typename T> class program {
+        std::vector<instruction> code;
+        std::vector<T> constants;
+        std::vector<std::string> variables;
+        std::size_t stack_size = 0;
+        std::size_t temps_number = 0;
+
+        friend class expression_dag<T>;
+
+        program() = default;
+
+        void emit(const instruction instr, std::size_t& depth) {
+            switch (instr.kind) {
+                case instruction_kind::OPERATION:
+                    if (depth < 2)
+                        throw std::runtime_error("Missing operand");
+
+                    --depth;
+                    break;
+
+                case instruction_kind::STORE:
+                    temps_number = std::max<std::size_t>(temps_number, instr.operand + 1);
+                    break;
+
+                default:
+                    stack_size = std::max(stack_size, ++depth);
+                    break;
+            }
+
+            code.push_back(instr);
+        }
+
+        // Sink of shunting_yard, operations are emitted instead of being applied
+        struct compiler {
+            program result;
+            std::size_t depth = 0;
+
+            void on_number(const std::string_view token) {
+                result.constants.push_back(parse_literal<T>(token));
+
+                const auto index = static_cast<std::uint32_t>(result.constants.size() - 1);
+                result.emit({ instruction_kind::CONSTANT, opcode::PLUS, index }, depth);
+            }
+
+            void on_variable(const std::string_view token) {
+                result.emit({ instruction_kind::VARIABLE, opcode::PLUS, result.variable_index(token) }, depth);
+            }
+
+            void on_operation(const opcode code) {
+                result.emit({ instruction_kind::OPERATION, code, 0 }, depth);
+            }
+        };
+
+        std::uint32_t variable_index(const std::string_view name) {
+            const auto it = std::find(variables.begin(), variables.end(), name);
+
+            if (it != variables.end())
+                return static_cast<std::uint32_t>(it - variables.begin());
+
+            variables.emplace_back(name);
+            return static_cast<std::uint32_t>(variables.size() - 1);
+        }
+
+    public:
+        static program compile(const std::string_view expression) {
+            compiler sink;
+            shunting_yard<compiler> parser(sink);
+            lexer tokens(expression);
+
+            while (const auto token = tokens.next())
+                parser.feed(*token);
+
+            parser.finish();
+
+            if (sink.depth != 1)
+                throw std::runtime_error("Expression must have exactly one result");
+
+            return std::move(sink.result);
+        }
+
+        // Names of variables in order of their first appearance,
+        // bindings are passed in the same order
+        const std::vector<std::string>& get_variables() const { return variables; }
+
+        // Values needed for evaluation: the stack itself and temporary slots after it
+        std::size_t get_stack_size() const { return stack_size + temps_number; }
+
+        // Program with folded constants and shared common subexpressions (see expression_dag)
+        program optimize() const;
+
+        // Program as RPN text. Values stored to the k-th temporary slot are marked with =$k,
+        // so shared subexpressions are written once and then referred as $k
+        std::string to_rpn() const {
+            std::string result;
+
+            for (const auto& instr : code) {
+                if (!result.empty())
+                    result += ' ';
+
+                switch (instr.kind) {
+                    case instruction_kind::CONSTANT: result += std::to_string(constants[instr.operand]); break;
+                    case instruction_kind::VARIABLE: result += variables[instr.operand]; break;
+                    case instruction_kind::OPERATION: result += operation::get_name(instr.code); break;
+                    case instruction_kind::STORE: result += "=$" + std::to_string(instr.operand); break;
+                    case instruction_kind::LOAD: result += "$" + std::to_string(instr.operand); break;
+                }
+            }
 
-    std::string whole_input;
-    std::getline(std::cin, whole_input);
+            return result;
+        }
+
+        const std::vector<instruction>& get_code() const { return code; }
+
+        // Evaluates program with bindings[i] as the value of the i-th variable
+        T evaluate(const T* const bindings, T* const stack) const {
+            auto* top = stack;
+            auto* const temps = stack + stack_size;
+
+            for (const auto& instr : code) {
+                switch (instr.kind) {
+                    case instruction_kind::CONSTANT:
+                        *top++ = constants[instr.operand];
+                        break;
 
-    std::stringstream ss(whole_input);
-    std::string input;
+                    case instruction_kind::VARIABLE:
+                        *top++ = bindings[instr.operand];
+                        break;
 
-    while (ss >> input) {
-        if (is_digit(input)) {
-            const int num = std::stoi(input);
-            nums.push(num);
-        } else {
-            const auto sign = operation::parse(input);
+                    case instruction_kind::OPERATION:
+                        --top;
+                        top[-1] = operation::apply(instr.code, top[-1], *top);
+                        break;
 
-            if (sign.get_value() == ",") {
-                while (operations.get_last()->get_value() != "(") {
-                    const auto res = (*operations.pop())(*nums.pop(), *nums.pop());
-                    nums.push(res);
+                    case instruction_kind::STORE:
+                        temps[instr.operand] = top[-1];
+                        break;
+
+                    case instruction_kind::LOAD:
+                        *top++ = temps[instr.operand];
+                        break;
                 }
-            } else if (sign.get_value() == ")") {
-                while (operations.get_last()->get_value() != "(") {
-                    const auto res = (*operations.pop())(*nums.pop(), *nums.pop());
-                    nums.push(res);
+            }
+
+            return stack[0];
+        }
+
+        // Evaluates program for batch_size sets of bindings stored one after another
+        // (get_variables().size() values each), stack is allocated once per batch
+        void evaluate(const T* const bindings, const std::size_t batch_size, T* const results) const {
+            std::vector<T> stack(get_stack_size());
+            const auto variables_number = variables.size();
+
+            for (std::size_t i = 0; i < batch_size; ++i)
+                results[i] = evaluate(bindings + i * variables_number, stack.data());
+        }
+
+        // Evaluates program for rows sets of bindings stored by columns:
+        // columns[v][row] is the value of the v-th variable.
+        // Rows are processed in blocks, every instruction is dispatched once per block
+        // and applied to the whole block with columnar::apply,
+        // variables are read from the columns in place
+        void evaluate_columns(const T* const* const columns, const std::size_t rows, T* const results) const {
+            constexpr auto BLOCK_ROWS = columnar::BLOCK_ROWS;
+
+            // Every stack level has its own block, slots point either to it or to the column
+            std::vector<T> blocks(stack_size * BLOCK_ROWS);
+            std::vector<const T*> slots(stack_size);
+            std::vector<T> temp_blocks(temps_number * BLOCK_ROWS);
+
+            // Constants are broadcast once per call
+            std::vector<T> constant_blocks(constants.size() * BLOCK_ROWS);
+
+            for (std::size_t c = 0; c < constants.size(); ++c)
+                std::fill_n(constant_blocks.data() + c * BLOCK_ROWS, BLOCK_ROWS, constants[c]);
+
+            for (std::size_t row = 0; row < rows; row += BLOCK_ROWS) {
+                const auto size = std::min(BLOCK_ROWS, rows - row);
+                std::size_t depth = 0;
+
+                for (const auto& instr : code) {
+                    switch (instr.kind) {
+                        case instruction_kind::CONSTANT:
+                            slots[depth++] = constant_blocks.data() + instr.operand * BLOCK_ROWS;
+                            break;
+
+                        case instruction_kind::VARIABLE:
+                            slots[depth++] = columns[instr.operand] + row;
+                            break;
+
+                        case instruction_kind::OPERATION: {
+                            --depth;
+                            auto* const out = blocks.data() + (depth - 1) * BLOCK_ROWS;
+                            columnar::apply(instr.code, slots[depth - 1], slots[depth], out, size);
+                            slots[depth - 1] = out;
+                            break;
+                        }
+
+                        case instruction_kind::STORE:
+                            std::copy_n(slots[depth - 1], size, temp_blocks.data() + instr.operand * BLOCK_ROWS);
+                            break;
+
+                        case instruction_kind::LOAD:
+                            slots[depth++] = temp_blocks.data() + instr.operand * BLOCK_ROWS;
+                            break;
+                    }
                 }
 
-                operations.pop();
+                std::copy_n(slots[0], size, results + row);
+            }
+        }
+    };
+
+    // Expression as a DAG: identical subexpressions are hash-consed into one node,
+    // subtrees with constant operands only are folded while the DAG is built.
+    // Operands of commutative operations are ordered, so a + b and b + a are the same node.
+    // Nodes are created after their operands, so ids are in topological order
+
+    template <typename T> class expression_dag {
+        static constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+
+        struct node {
+            instruction_kind kind;
+            opcode code;
+            std::uint32_t operand;
+            std::uint32_t lhs;
+            std::uint32_t rhs;
 
-                if (!operations.is_empty() && operations.get_last()->get_priority() == 2) {
-                    const auto res = (*operations.pop())(*nums.pop(), *nums.pop());
-                    nums.push(res);
+            bool operator==(const node&) const = default;
+        };
+
+        struct node_hash {
+            std::size_t operator()(const node& n) const {
+                auto hash = static_cast<std::size_t>(n.kind) * 31 + static_cast<std::size_t>(n.code);
+                hash = hash * 1000003 + n.operand;
+                hash = hash * 1000003 + n.lhs;
+                return hash * 1000003 + n.rhs;
+            }
+        };
+
+        std::vector<node> nodes;
+        std::vector<T> constants;
+        std::vector<std::string> variables;
+        std::unordered_map<node, std::uint32_t, node_hash> node_ids;
+        std::unordered_map<T, std::uint32_t> constant_ids;
+        std::uint32_t root = NONE;
+
+        std::uint32_t add_node(const node& n) {
+            const auto [it, inserted] = node_ids.emplace(n, static_cast<std::uint32_t>(nodes.size()));
+
+            if (inserted)
+                nodes.push_back(n);
+
+            return it->second;
+        }
+
+        std::uint32_t add_constant(const T& value) {
+            const auto [it, inserted] = constant_ids.emplace(value, static_cast<std::uint32_t>(constants.size()));
+
+            if (inserted)
+                constants.push_back(value);
+
+            return add_node({ instruction_kind::CONSTANT, opcode::PLUS, it->second, NONE, NONE });
+        }
+
+        std::uint32_t add_operation(const opcode code, std::uint32_t lhs, std::uint32_t rhs) {
+            const auto& left = nodes[lhs];
+            const auto& right = nodes[rhs];
+
+            if (left.kind == instruction_kind::CONSTANT && right.kind == instruction_kind::CONSTANT)
+                return add_constant(operation::apply(code, constants[left.operand], constants[right.operand]));
+
+            const bool is_commutative =
+                    code == opcode::PLUS || code == opcode::MUL || code == opcode::MIN || code == opcode::MAX;
+
+            if (is_commutative && lhs > rhs)
+                std::swap(lhs, rhs);
+
+            return add_node({ instruction_kind::OPERATION, code, 0, lhs, rhs });
+        }
+
+    public:
+        // Builds DAG by simulating the evaluation of the program on a stack of node ids
+        explicit expression_dag(const program<T>& source) : variables(source.variables) {
+            std::vector<std::uint32_t> ids;
+            std::vector<std::uint32_t> temps(source.temps_number, NONE);
+
+            for (const auto& instr : source.code) {
+                switch (instr.kind) {
+                    case instruction_kind::CONSTANT:
+                        ids.push_back(add_constant(source.constants[instr.operand]));
+                        break;
+
+                    case instruction_kind::VARIABLE:
+                        ids.push_back(add_node({ instruction_kind::VARIABLE, opcode::PLUS, instr.operand, NONE, NONE }));
+                        break;
+
+                    case instruction_kind::OPERATION: {
+                        const auto rhs = ids.back();
+                        ids.pop_back();
+                        ids.back() = add_operation(instr.code, ids.back(), rhs);
+                        break;
+                    }
+
+                    case instruction_kind::STORE:
+                        temps[instr.operand] = ids.back();
+                        break;
+
+                    case instruction_kind::LOAD:
+                        ids.push_back(temps[instr.operand]);
+                        break;
+                }
+            }
+
+            root = ids.back();
+        }
+
+        std::size_t get_size() const { return nodes.size(); }
+
+        // Emits every node once: operations used more than once are stored to temporary slots
+        // right after they are computed and loaded later. Constants and variables are cheap to push again.
+        // Traversal uses explicit stack, so long chains don't overflow the call stack
+        program<T> to_program() const {
+            program<T> result;
+            result.variables = variables;
+
+            // Uses are counted from the root down, parents always have greater ids
+            std::vector<std::uint32_t> uses(nodes.size());
+            uses[root] = 1;
+
+            for (auto id = root + 1; id-- > 0;) {
+                if (uses[id] == 0 || nodes[id].kind != instruction_kind::OPERATION)
+                    continue;
+
+                ++uses[nodes[id].lhs];
+                ++uses[nodes[id].rhs];
+            }
+
+            std::vector<std::uint32_t> temp_slots(nodes.size(), NONE);
+            std::vector<std::uint32_t> constant_indices(constants.size(), NONE);
+            std::uint32_t temps_number = 0;
+            std::size_t depth = 0;
+
+            // Pairs of (node, whether its operands are already emitted)
+            std::vector<std::pair<std::uint32_t, bool>> pending { { root, false } };
+
+            while (!pending.empty()) {
+                const auto [id, is_expanded] = pending.back();
+                pending.pop_back();
+
+                const auto& n = nodes[id];
+
+                if (temp_slots[id] != NONE) {
+                    result.emit({ instruction_kind::LOAD, opcode::PLUS, temp_slots[id] }, depth);
+                    continue;
                 }
-            } else if (sign.get_value() != "(") {
-                while (!operations.is_empty() && operations.get_last()->get_priority() >= sign.get_priority()) {
-                    const auto res = (*operations.pop())(*nums.pop(), *nums.pop());
-                    nums.push(res);
+
+                switch (n.kind) {
+                    case instruction_kind::CONSTANT:
+                        if (constant_indices[n.operand] == NONE) {
+                            constant_indices[n.operand] = static_cast<std::uint32_t>(result.constants.size());
+                            result.constants.push_back(constants[n.operand]);
+                        }
+
+                        result.emit({ instruction_kind::CONSTANT, opcode::PLUS, constant_indices[n.operand] }, depth);
+                        break;
+
+                    case instruction_kind::VARIABLE:
+                        result.emit({ instruction_kind::VARIABLE, opcode::PLUS, n.operand }, depth);
+                        break;
+
+                    default:
+                        if (!is_expanded) {
+                            pending.emplace_back(id, true);
+                            pending.emplace_back(n.rhs, false);
+                            pending.emplace_back(n.lhs, false);
+                            break;
+                        }
+
+                        result.emit({ instruction_kind::OPERATION, n.code, 0 }, depth);
+
+                        if (uses[id] > 1) {
+                            temp_slots[id] = temps_number++;
+                            result.emit({ instruction_kind::STORE, opcode::PLUS, temp_slots[id] }, depth);
+                        }
+
+                        break;
                 }
             }
 
-            if (sign.get_value() != "," && sign.get_value() != ")")
-                operations.push(sign);
+            return result;
+        }
+
+        // Optimized expression as RPN text, see program::to_rpn
+        std::string to_rpn() const { return to_program().to_rpn(); }
+    };
+
+    template <typename T> program<T> program<T>::optimize() const {
+        return expression_dag<T>(*this).to_program();
+    }
+
+    // Number token to value without std::from_chars (it isn't constexpr before C++23).
+    // As in parse_literal, number which doesn't fit into T is invalid:
+    // throw stops constant evaluation, so such formula is a compilation error
+
+    template <typename T> constexpr T parse_number(const std::string_view token) {
+        T value {};
+
+        for (const auto c : token) {
+            const auto digit = T(c - '0');
+
+            if (c < '0' || c > '9' || value > (std::numeric_limits<T>::max() - digit) / 10)
+                throw std::runtime_error("Invalid number");
+
+            value = value * 10 + digit;
+        }
+
+        return value;
+    }
+
+    // Program which is compiled from the formula at compile time. Code, constants and the stack
+    // are kept in std::array, so constexpr program is a literal value: calls of it are inlined
+    // by the compiler without any parsing, formula without variables becomes a constant.
+    // Capacity limits the number of instructions, constants and the depth of stacks.
+    // Errors in the formula (unknown variable, unbalanced braces, too long formula) are compilation errors
+
+    template <typename T, std::size_t Capacity, std::size_t VariablesNumber> class fixed_program {
+        std::array<instruction, Capacity> code {};
+        std::array<T, Capacity> constants {};
+        std::size_t code_size = 0;
+        std::size_t constants_size = 0;
+
+        constexpr void emit(const instruction instr, std::size_t& depth) {
+            if (code_size == Capacity)
+                throw std::runtime_error("Formula is too long");
+
+            if (instr.kind == instruction_kind::OPERATION) {
+                if (depth < 2)
+                    throw std::runtime_error("Missing operand");
+
+                --depth;
+            } else if (++depth > Capacity) {
+                throw std::runtime_error("Formula is too long");
+            }
+
+            code[code_size++] = instr;
+        }
+
+        // Sink of shunting_yard, variables are looked up in names
+        struct compiler {
+            fixed_program result;
+            const std::string_view* names;
+            std::size_t depth = 0;
+
+            constexpr void on_number(const std::string_view token) {
+                if (result.constants_size == Capacity)
+                    throw std::runtime_error("Formula is too long");
+
+                result.constants[result.constants_size] = parse_number<T>(token);
+                const auto index = static_cast<std::uint32_t>(result.constants_size++);
+                result.emit({ instruction_kind::CONSTANT, opcode::PLUS, index }, depth);
+            }
+
+            constexpr void on_variable(const std::string_view token) {
+                for (std::size_t i = 0; i < VariablesNumber; ++i) {
+                    if (names[i] == token) {
+                        result.emit({ instruction_kind::VARIABLE, opcode::PLUS, static_cast<std::uint32_t>(i) }, depth);
+                        return;
+                    }
+                }
+
+                throw std::runtime_error("Unknown variable");
+            }
+
+            constexpr void on_operation(const opcode code) {
+                result.emit({ instruction_kind::OPERATION, code, 0 }, depth);
+            }
+        };
+
+    public:
+        constexpr fixed_program() = default;
+
+        static constexpr fixed_program compile(const std::string_view formula, const std::string_view* const names) {
+            compiler sink { {}, names };
+            shunting_yard<compiler, fixed_stack<operation, Capacity>> parser(sink);
+            lexer tokens(formula);
+
+            while (const auto token = tokens.next())
+                parser.feed(*token);
+
+            parser.finish();
+
+            if (sink.depth != 1)
+                throw std::runtime_error("Expression must have exactly one result");
+
+            return sink.result;
+        }
+
+        // Values of variables are passed in the same order as their names were
+        template <typename... Values> requires (sizeof...(Values) == VariablesNumber)
+        constexpr T operator()(const Values... values) const {
+            const std::array<T, VariablesNumber> bindings { static_cast<T>(values)... };
+            std::array<T, Capacity> stack {};
+            std::size_t top = 0;
+
+            for (std::size_t i = 0; i < code_size; ++i) {
+                const auto instr = code[i];
+
+                switch (instr.kind) {
+                    case instruction_kind::CONSTANT:
+                        stack[top++] = constants[instr.operand];
+                        break;
+
+                    case instruction_kind::VARIABLE:
+                        stack[top++] = bindings[instr.operand];
+                        break;
+
+                    case instruction_kind::OPERATION:
+                        --top;
+                        stack[top - 1] = operation::apply(instr.code, stack[top - 1], stack[top]);
+                        break;
+
+                    default:
+                        break;
+                }
+            }
+
+            return stack[0];
         }
+    };
+
+    // Compiles formula with variables at compile time:
+    // constexpr auto f = compile_formula<int>("x * 2 + max(y, 3)", { "x", "y" }); f(4, 1) == 11
+
+    template <typename T, std::size_t Capacity = 64, std::size_t VariablesNumber>
+    constexpr fixed_program<T, Capacity, VariablesNumber> compile_formula(
+            const std::string_view formula,
+            const std::string_view (&names)[VariablesNumber]
+    ) {
+        return fixed_program<T, Capacity, VariablesNumber>::compile(formula, names);
     }
 
-    while (!operations.is_empty()) {
-        const auto res = (*operations.pop())(*nums.pop(), *nums.pop());
-        nums.push(res);
+    template <typename T, std::size_t Capacity = 64>
+    constexpr fixed_program<T, Capacity, 0> compile_formula(const std::string_view formula) {
+        return fixed_program<T, Capacity, 0>::compile(formula, nullptr);
+    }
+
+    // Value of the formula without variables, calculated at compile time if formula is constant
+    template <typename T, std::size_t Capacity = 64> constexpr T evaluate_formula(const std::string_view formula) {
+        return compile_formula<T, Capacity>(formula)();
+    }
+
+    static_assert(evaluate_formula<int>("max(3, 4) * 2 - 10 / 3") == 5);
+    static_assert(evaluate_formula<int>("7 / 0 + min(1, 2)") == 1);
+    static_assert(evaluate_formula<int>("2147483647 + 0") == 2147483647);
+    static_assert(compile_formula<int>("x * 2 + max(y, 3)", { "x", "y" })(4, 1) == 11);
+
+    // Batch mode: every line of the input is an independent expression.
+    // Input is split into line-aligned chunks which are evaluated by the pool of workers,
+    // every worker reuses its own stacks for all of its lines.
+    // Results are written in input order through the reorder buffer.
+    // At most MAX_IN_FLIGHT_PER_THREAD chunks per worker are read but not written yet,
+    // so memory doesn't depend on the input size. Invalid lines are answered with "error"
+
+    class batch_evaluator {
+        static constexpr std::size_t CHUNK_SIZE = 1 << 20;
+        static constexpr std::size_t MAX_IN_FLIGHT_PER_THREAD = 2;
+
+        struct chunk {
+            std::size_t index;
+            std::string text;
+        };
+
+        std::istream& input;
+        std::ostream& output;
+        const std::size_t threads;
+
+        std::mutex mutex;
+        std::condition_variable work_ready;
+        std::condition_variable result_ready;
+
+        std::deque<chunk> queue;
+        bool is_input_end = false;
+
+        // Results of chunks which are evaluated before the previous ones
+        std::map<std::size_t, std::string> reorder_buffer;
+        std::size_t next_to_write = 0;
+        std::size_t in_flight = 0;
+
+        // More workers only contend for the cores, it also keeps
+        // threads * MAX_IN_FLIGHT_PER_THREAD far from overflow
+        static std::size_t max_threads() {
+            return 4 * std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+        }
+
+        static void evaluate_lines(
+                const std::string_view text,
+                shunting_yard<stack_evaluator<int>>& parser,
+                stack_evaluator<int>& evaluator,
+                std::string& result
+        ) {
+            std::size_t line_begin = 0;
+
+            while (line_begin < text.size()) {
+                auto line_end = text.find('\n', line_begin);
+
+                if (line_end == std::string_view::npos)
+                    line_end = text.size();
+
+                parser.reset();
+                evaluator.reset();
+
+                try {
+                    lexer tokens(text.substr(line_begin, line_end - line_begin));
+
+                    while (const auto token = tokens.next())
+                        parser.feed(*token);
+
+                    parser.finish();
+                    result += std::to_string(evaluator.get_result());
+                } catch (const std::exception&) {
+                    result += "error";
+                }
+
+                result += '\n';
+                line_begin = line_end + 1;
+            }
+        }
+
+        void work() {
+            stack_evaluator<int> evaluator;
+            shunting_yard<stack_evaluator<int>> parser(evaluator);
+
+            while (true) {
+                chunk task;
+
+                {
+                    std::unique_lock lock(mutex);
+                    work_ready.wait(lock, [this] { return !queue.empty() || is_input_end; });
+
+                    if (queue.empty())
+                        return;
+
+                    task = std::move(queue.front());
+                    queue.pop_front();
+                }
+
+                std::string result;
+                evaluate_lines(task.text, parser, evaluator, result);
+
+                {
+                    std::lock_guard lock(mutex);
+                    reorder_buffer.emplace(task.index, std::move(result));
+                }
+
+                result_ready.notify_all();
+            }
+        }
+
+        // Writes results which are next in order, lock is released while writing
+        void write_ready(std::unique_lock<std::mutex>& lock) {
+            for (auto it = reorder_buffer.find(next_to_write); it != reorder_buffer.end(); it = reorder_buffer.find(next_to_write)) {
+                const auto result = std::move(it->second);
+                reorder_buffer.erase(it);
+                ++next_to_write;
+                --in_flight;
+
+                lock.unlock();
+                output << result;
+                lock.lock();
+            }
+        }
+
+        void submit(chunk&& task) {
+            std::unique_lock lock(mutex);
+
+            while (in_flight >= threads * MAX_IN_FLIGHT_PER_THREAD) {
+                result_ready.wait(lock, [this] { return reorder_buffer.contains(next_to_write); });
+                write_ready(lock);
+            }
+
+            queue.push_back(std::move(task));
+            ++in_flight;
+            lock.unlock();
+            work_ready.notify_one();
+        }
+
+    public:
+        batch_evaluator(std::istream& input, std::ostream& output, const std::size_t threads) :
+                input(input), output(output), threads(std::clamp<std::size_t>(threads, 1, max_threads())) {}
+
+        void run() {
+            std::vector<std::thread> workers;
+            workers.reserve(threads);
+
+            for (std::size_t i = 0; i < threads; ++i)
+                workers.emplace_back(&batch_evaluator::work, this);
+
+            std::vector<char> buffer(CHUNK_SIZE);
+            std::string carry;
+            std::size_t chunks_number = 0;
+
+            // Chunk ends with the last complete line, the rest goes to the next chunk
+            while (input.read(buffer.data(), static_cast<std::streamsize>(CHUNK_SIZE)) || input.gcount() > 0) {
+                const std::string_view block(buffer.data(), static_cast<std::size_t>(input.gcount()));
+                const auto last_line_end = block.rfind('\n');
+
+                if (last_line_end == std::string_view::npos) {
+                    carry += block;
+                    continue;
+                }
+
+                std::string text = std::move(carry);
+                text += block.substr(0, last_line_end + 1);
+                carry = block.substr(last_line_end + 1);
+
+                submit({ chunks_number++, std::move(text) });
+            }
+
+            if (!carry.empty())
+                submit({ chunks_number++, std::move(carry) });
+
+            std::unique_lock lock(mutex);
+            is_input_end = true;
+            work_ready.notify_all();
+
+            while (next_to_write < chunks_number) {
+                result_ready.wait(lock, [this] { return reorder_buffer.contains(next_to_write); });
+                write_ready(lock);
+            }
+
+            lock.unlock();
+
+            for (auto& worker : workers)
+                worker.join();
+        }
+    };
+}
+
+// With `--batch [threads]` every line of the input is evaluated as a separate expression,
+// otherwise the first line is evaluated
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && std::string_view(argv[1]) == "--batch") {
+        std::ios_base::sync_with_stdio(false);
+
+        const auto threads = argc >= 3 ? std::strtoull(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+        batch_evaluator(std::cin, std::cout, threads).run();
+        return 0;
     }
 
-    std::cout << *nums.pop();
+    // Expression is evaluated while it is read, so memory doesn't depend on its length
+    stack_evaluator<int> evaluator;
+    shunting_yard<stack_evaluator<int>> parser(evaluator);
+    chunked_lexer tokens(std::cin);
+
+    while (const auto token = tokens.next())
+        parser.feed(*token);
+
+    parser.finish();
+    std::cout << evaluator.get_result();
 
     return 0;
 }
@@ -2,13 +2,17 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 #include <functional>
 #include <cstring>
+#include <cstdint>
 #include <numeric>
 #include <optional>
 #include <list>
 #include <vector>
+#include <algorithm>
 
 namespace dsa_hw {
     template <typename K, typename V> struct map {
@@ -38,23 +42,138 @@ namespace dsa_hw {
         inline bool is_empty() const { return get_size() == 0; }
     };
 
+    // Robin Hood hash map with linear probing.
+    // Capacity is a power of two, every slot remembers its distance from the home slot,
+    // richer entries (closer to home) give their place to poorer ones on insertion,
+    // so lookup stops as soon as it meets an empty slot or an entry closer to its home than the key would be.
+    // Deletion shifts the following entries back instead of leaving tombstones.
+    // One extra slot data[size] is always empty: it is end() and the result of get_if_present on miss
+
     template <typename K, typename V> class hash_map : public map<K, V> {
+        static constexpr std::size_t DEFAULT_CAPACITY = 100000;
+        static constexpr std::size_t MIN_SIZE = 8;
+
         std::size_t size;
         std::size_t elems = 0;
         std::optional<std::pair<K, V>>* data;
+        std::uint32_t* distances;
         std::function<std::size_t(const K&)> hash_algo;
 
-        inline void resize() {
-            size <<= 1;
+        // Max load factor is 3 / 4
+        static inline std::size_t get_size_for(const std::size_t capacity) {
+            std::size_t new_size = MIN_SIZE;
 
-            data = reinterpret_cast<std::optional<std::pair<K, V>>*>(
-                    std::realloc(data, size * sizeof(std::optional<std::pair<K, V>>))
-            );
+            while (new_size / 4 * 3 < capacity)
+                new_size <<= 1;
+
+            return new_size;
+        }
+
+        // User hashes may be poor in low bits (hash_string is taken modulo prime)
+        static inline std::size_t mix(std::size_t hash) {
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDULL;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+        inline std::size_t get_home(const K& key) const { return mix(hash_algo(key)) & (size - 1); }
+
+        inline void allocate(const std::size_t new_size) {
+            size = new_size;
+            data = new std::optional<std::pair<K, V>>[size + 1];
+            distances = new std::uint32_t[size]();
+        }
+
+        // Index of the key or size if it is absent
+        inline std::size_t find_index(const K& key, const std::size_t home) const {
+            const auto mask = size - 1;
+            std::uint32_t dist = 0;
+
+            for (auto index = home;; ++dist, index = (index + 1) & mask) {
+                if (!data[index].has_value() || distances[index] < dist)
+                    return size;
+
+                if (data[index]->first == key)
+                    return index;
+            }
         }
 
-        inline void resize_if_not_enough_space() {
-            if (elems == size)
-                resize();
+        // Places entry which is known to be absent, returns its final index
+        inline std::size_t place(std::pair<K, V>&& entry, const std::size_t home) {
+            const auto mask = size - 1;
+            auto result = size;
+            std::uint32_t dist = 0;
+
+            for (auto index = home;; ++dist, index = (index + 1) & mask) {
+                if (!data[index].has_value()) {
+                    data[index].emplace(std::move(entry));
+                    distances[index] = dist;
+                    ++elems;
+                    return result == size ? index : result;
+                }
+
+                if (distances[index] < dist) {
+                    std::swap(entry, *data[index]);
+                    std::swap(dist, distances[index]);
+
+                    if (result == size)
+                        result = index;
+                }
+            }
+        }
+
+        inline void rehash(const std::size_t new_size) {
+            auto* const old_data = data;
+            auto* const old_distances = distances;
+            const auto old_size = size;
+
+            allocate(new_size);
+            elems = 0;
+
+            for (auto* opt = old_data; opt != old_data + old_size; ++opt)
+                if (opt->has_value())
+                    place(std::move(**opt), get_home((*opt)->first));
+
+            delete[] old_data;
+            delete[] old_distances;
+        }
+
+        // Returns true if the table was rebuilt and home slots have to be recalculated
+        inline bool grow_if_not_enough_space() {
+            if (elems + 1 <= size / 4 * 3)
+                return false;
+
+            rehash(size << 1);
+            return true;
+        }
+
+        inline std::size_t insert_or_find(const K& key) {
+            auto home = get_home(key);
+            const auto index = find_index(key, home);
+
+            if (index != size)
+                return index;
+
+            if (grow_if_not_enough_space())
+                home = get_home(key);
+
+            return place(std::make_pair(key, V()), home);
+        }
+
+        inline void assign(std::pair<K, V>&& entry) {
+            auto home = get_home(entry.first);
+            const auto index = find_index(entry.first, home);
+
+            if (index != size) {
+                data[index]->second = std::move(entry.second);
+                return;
+            }
+
+            if (grow_if_not_enough_space())
+                home = get_home(entry.first);
+
+            place(std::move(entry), home);
         }
 
     public:
@@ -119,138 +238,28 @@ namespace dsa_hw {
         };
 
         hash_map(const std::size_t initial_capacity, std::function<std::size_t(const K&)> hash_algo) {
-            size = initial_capacity > 0 ? initial_capacity : 100000;
-
-            data = reinterpret_cast<std::optional<std::pair<K, V>>*>(
-                    std::calloc(size, sizeof(std::optional<std::pair<K, V>>))
-            );
-
-            for (auto* opt = data; opt != data + size; ++opt)
-                *opt = std::nullopt;
-
-            this->hash_algo = hash_algo;
-        }
-
-        hash_map(std::function<std::size_t(const K&)> hash_algo) {
-            size = 100000;
-
-            data = reinterpret_cast<std::optional<std::pair<K, V>>*>(
-                    std::calloc(size, sizeof(std::optional<std::pair<K, V>>))
-            );
-
-            for (auto* opt = data; opt != data + size; ++opt)
-                *opt = std::nullopt;
-
+            allocate(get_size_for(initial_capacity > 0 ? initial_capacity : DEFAULT_CAPACITY));
             this->hash_algo = hash_algo;
         }
 
-        ~hash_map() { std::free(data); }
-
-        inline void insert(const std::pair<K, V> entry) override {
-            resize_if_not_enough_space();
-            const auto [key, value] = entry;
-            const auto hashed_ind = hash_algo(key) % size;
-
-            for (std::size_t i = 0; i < size; ++i) {
-                const auto index = (hashed_ind + i) % size;
-
-                if (data[index].has_value()) {
-                    auto map_entry = data[index].value();
-
-                    if (map_entry.first == key) {
-                        map_entry.second = value;
-                        return;
-                    }
-                } else {
-                    data[index] = std::make_optional(std::make_pair(key, value));
-                    ++elems;
-                    return;
-                }
-            }
-        }
-
-        inline void insert(std::pair<K, V>&& entry) override {
-            resize_if_not_enough_space();
-            const auto [key, value] = entry;
-            const auto hashed_ind = hash_algo(key) % size;
-
-            for (std::size_t i = 0; i < size; ++i) {
-                const auto index = (hashed_ind + i) % size;
+        hash_map(std::function<std::size_t(const K&)> hash_algo) : hash_map(DEFAULT_CAPACITY, hash_algo) {}
 
-                if (data[index].has_value()) {
-                    auto map_entry = data[index].value();
+        hash_map(const hash_map&) = delete;
+        hash_map& operator=(const hash_map&) = delete;
 
-                    if (map_entry.first == key) {
-                        map_entry.second = value;
-                        return;
-                    }
-                } else {
-                    data[index] = std::make_optional(std::make_pair(key, value));
-                    ++elems;
-                    return;
-                }
-            }
+        ~hash_map() {
+            delete[] data;
+            delete[] distances;
         }
 
-        inline void insert(const K key, const V value) override {
-            resize_if_not_enough_space();
-            const auto hashed_ind = hash_algo(key) % size;
-
-            for (std::size_t i = 0; i < size; ++i) {
-                const auto index = (hashed_ind + i) % size;
+        inline void insert(const std::pair<K, V> entry) override { assign(std::pair<K, V>(entry)); }
+        inline void insert(std::pair<K, V>&& entry) override { assign(std::move(entry)); }
 
-                if (data[index].has_value()) {
-                    auto entry = data[index].value();
-
-                    if (entry.first == key) {
-                        entry.second = value;
-                        return;
-                    }
-                } else {
-                    data[index] = std::make_optional(std::make_pair(key, value));
-                    ++elems;
-                    return;
-                }
-            }
-        }
-
-        inline void insert(K&& key, V&& value) override {
-            resize_if_not_enough_space();
-            const auto hashed_ind = hash_algo(key) % size;
-
-            for (std::size_t i = 0; i < size; ++i) {
-                const auto index = (hashed_ind + i) % size;
-
-                if (data[index].has_value()) {
-                    auto entry = data[index].value();
-
-                    if (entry.first == key) {
-                        entry.second = value;
-                        return;
-                    }
-                } else {
-                    data[index] = std::make_optional(std::make_pair(key, value));
-                    ++elems;
-                    return;
-                }
-            }
-        }
+        inline void insert(const K key, const V value) override { assign(std::make_pair(key, value)); }
+        inline void insert(K&& key, V&& value) override { assign(std::make_pair(std::move(key), std::move(value))); }
 
         inline iterator find(const K& key) {
-            const auto hashed_ind = hash_algo(key) % size;
-
-            for (std::size_t i = 0; i < size; ++i) {
-                const auto index = (hashed_ind + i) % size;
-
-                if (data[index].has_value()) {
-                    auto entry = data[index].value();
-
-                    if (entry.first == key)
-                        return iterator(data + index, data, data + size);
-                }
-            }
-
-            return end();
+            return iterator(data + find_index(key, get_home(key)), data, data + size);
         }
 
         inline std::optional<std::pair<K, V>>& get_if_present(const K& key) override {
@@ -258,60 +267,34 @@ namespace dsa_hw {
         }
 
         inline std::pair<K, V>& get(const K& key) override {
-            const auto hashed_ind = hash_algo(key) % size;
-            auto empty_index = -1;
-            auto elem_it = end();
-
-            for (std::size_t i = 0; i < size; ++i) {
-                const auto index = (hashed_ind + i) % size;
-
-                if (data[index].has_value()) {
-                    auto entry = data[index].value();
-
-                    if (entry.first == key)
-                        elem_it = iterator(data + index, data, data + size);
-                } else {
-                    if (empty_index == -1)
-                        empty_index = index;
-                }
-            }
-
-            if (empty_index == -1) {
-                resize();
-
-                for (std::size_t i = 0; i < size; ++i) {
-                    const auto index = (hashed_ind + i) % size;
-
-                    if (data[index].has_value()) {
-                        auto entry = data[hashed_ind].value();
-
-                        if (entry.first == key)
-                            elem_it = iterator(data + index, data, data + size);
-                    } else {
-                        if (empty_index == -1)
-                            empty_index = index;
-                    }
-                }
-            }
-
-            if (elem_it == end())
-                elem_it = iterator(data + empty_index, data, data + size);
-
-            if (!elem_it.ptr->has_value())
-                *elem_it.ptr = std::make_optional(std::make_pair(key, V()));
-
-            return elem_it.ptr->value();
+            // Insertion may rehash, so data must be read after it
+            const auto index = insert_or_find(key);
+            return *data[index];
         }
 
         inline bool remove(const K& key) override {
             const auto iter = find(key);
-            const auto has_value = iter->has_value();
+
+            if (!iter)
+                return false;
+
             remove(iter);
-            return has_value;
+            return true;
         }
 
+        // Backward shift: entries after the removed one move one slot closer to their homes
         inline void remove(const iterator it) {
-            *it.ptr = std::nullopt;
+            const auto mask = size - 1;
+            auto index = static_cast<std::size_t>(it.ptr - data);
+
+            for (auto next = (index + 1) & mask; data[next].has_value() && distances[next] > 0; next = (next + 1) & mask) {
+                data[index] = std::move(data[next]);
+                distances[index] = distances[next] - 1;
+                index = next;
+            }
+
+            data[index] = std::nullopt;
+            distances[index] = 0;
             --elems;
         }
 
@@ -710,47 +693,278 @@ namespace dsa_hw {
 }
 
 namespace {
-    template <typename T, typename RandomAccessIterator, typename Cmp> void merge_sort(
-            RandomAccessIterator begin,
-            RandomAccessIterator end,
-            const Cmp cmp
-    ) {
-        if (begin == end || begin + 1 == end)
-            return;
+    namespace multikey {
+        // Ranges smaller than it are sorted with insertion sort
+        constexpr std::size_t INSERTION_SORT_THRESHOLD = 16;
+
+        // Bytes of the string compared at once
+        constexpr std::size_t PREFIX_SIZE = sizeof(std::uint64_t);
+
+        // Index of the string with its PREFIX_SIZE bytes starting from the current depth
+        struct entry {
+            std::uint64_t prefix;
+            std::size_t index;
+        };
+
+        // Loads bytes [depth, depth + 8) in big-endian order, missing bytes are zeros,
+        // so prefixes are compared as integers in lexicographical order
+
+        inline std::uint64_t load_prefix(const std::string_view s, const std::size_t depth) {
+            unsigned char bytes[PREFIX_SIZE] = {};
+
+            if (depth < s.size())
+                std::memcpy(bytes, s.data() + depth, std::min(PREFIX_SIZE, s.size() - depth));
+
+            std::uint64_t prefix = 0;
+
+            for (const auto byte : bytes)
+                prefix = (prefix << 8) | byte;
+
+            return prefix;
+        }
+
+        // Suffixes are compared only when the range is small,
+        // strings are equal in the first depth bytes
+
+        template <typename String> void insertion_sort(
+                entry* const entries,
+                const std::size_t size,
+                const std::size_t depth,
+                const String& string
+        ) {
+            const auto less = [&](const entry& a, const entry& b) {
+                if (a.prefix != b.prefix)
+                    return a.prefix < b.prefix;
+
+                const auto cmp = string(a.index).substr(depth).compare(string(b.index).substr(depth));
+                return cmp < 0 || (cmp == 0 && a.index < b.index);
+            };
+
+            for (std::size_t i = 1; i < size; ++i) {
+                const auto elem = entries[i];
+                auto q = i;
+
+                for (; q > 0 && less(elem, entries[q - 1]); --q)
+                    entries[q] = entries[q - 1];
+
+                entries[q] = elem;
+            }
+        }
+
+        // Multikey quicksort (Bentley and Sedgewick): 3-way partition by the cached prefix,
+        // smaller and greater parts are sorted at the same depth,
+        // equal part continues from the next PREFIX_SIZE bytes, so common prefixes are never compared again.
+        // Only the two smaller parts are sorted recursively, the largest one is sorted in the loop,
+        // so the recursion depth is O(log(n)) even for long shared prefixes or bad pivots.
+        // Prefixes of entries must be loaded for the given depth
+
+        template <typename String> void sort(
+                entry* entries,
+                std::size_t size,
+                std::size_t depth,
+                const String& string
+        ) {
+            struct part {
+                entry* entries;
+                std::size_t size;
+                std::size_t depth;
+            };
+
+            while (size > 1) {
+                if (size < INSERTION_SORT_THRESHOLD) {
+                    insertion_sort(entries, size, depth, string);
+                    return;
+                }
+
+                const auto a = entries[0].prefix, b = entries[size / 2].prefix, c = entries[size - 1].prefix;
+                const auto pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
 
-        const auto mid = begin + (end - begin) / 2;
+                // [0, lt) < pivot, [lt, i) == pivot, [gt, size) > pivot
+                std::size_t lt = 0, i = 0, gt = size;
 
-        merge_sort<T>(begin, mid, cmp);
-        merge_sort<T>(mid, end, cmp);
+                while (i < gt) {
+                    if (entries[i].prefix < pivot)
+                        std::swap(entries[lt++], entries[i++]);
+                    else if (entries[i].prefix > pivot)
+                        std::swap(entries[i], entries[--gt]);
+                    else
+                        ++i;
+                }
+
+                // Strings that end inside of the prefix are equal to it padded with zeros,
+                // so they precede the longer ones and are ordered by length
+
+                auto* const equal = entries + lt;
+                auto* const unfinished = std::stable_partition(equal, entries + gt, [&](const entry& e) {
+                    return string(e.index).size() <= depth + PREFIX_SIZE;
+                });
+
+                std::sort(equal, unfinished, [&](const entry& x, const entry& y) {
+                    const auto x_size = string(x.index).size(), y_size = string(y.index).size();
+                    return x_size < y_size || (x_size == y_size && x.index < y.index);
+                });
+
+                std::for_each(unfinished, entries + gt, [&](entry& e) {
+                    e.prefix = load_prefix(string(e.index), depth + PREFIX_SIZE);
+                });
+
+                part parts[] = {
+                        { entries, lt, depth },
+                        { unfinished, static_cast<std::size_t>(entries + gt - unfinished), depth + PREFIX_SIZE },
+                        { entries + gt, size - gt, depth }
+                };
 
-        int i = 0, q = 0;
+                auto* const largest = std::max_element(std::begin(parts), std::end(parts), [](const part& x, const part& y) {
+                    return x.size < y.size;
+                });
 
-        auto* const sort_holder = new T[end - begin];
+                for (auto* p = std::begin(parts); p != std::end(parts); ++p)
+                    if (p != largest)
+                        sort(p->entries, p->size, p->depth, string);
 
-        while (begin + i != mid && mid + q != end) {
-            if (cmp(*(begin + i), *(mid + q))) {
-                sort_holder[i + q] = *(begin + i);
-                ++i;
-            } else {
-                sort_holder[i + q] = *(mid + q);
-                ++q;
+                entries = largest->entries;
+                size = largest->size;
+                depth = largest->depth;
             }
         }
+    }
+
+    // Moves elements according to order, where order[i] is the index of element
+    // which goes to the i-th position. Permutation is applied in place by following its cycles,
+    // every element is moved O(1) times. Order is left as identity
+
+    template <typename T, typename RandomAccessIterator> void apply_permutation(
+            const RandomAccessIterator begin,
+            std::vector<std::size_t>& order
+    ) {
+        for (std::size_t start = 0; start < order.size(); ++start) {
+            if (order[start] == start)
+                continue;
+
+            T displaced = std::move(*(begin + start));
+            auto i = start;
+
+            while (order[i] != start) {
+                const auto next = order[i];
+                *(begin + i) = std::move(*(begin + next));
+                order[i] = i;
+                i = next;
+            }
 
-        while (begin + i != mid) {
-            sort_holder[i + q] = *(begin + i);
-            ++i;
+            *(begin + i) = std::move(displaced);
+            order[i] = i;
         }
+    }
+
+    // Compact key of the element at index in the sorted collection
+
+    template <typename Key> struct keyed {
+        Key key;
+        std::size_t index;
+    };
+
+    // Sorts by compact keys instead of the elements themselves.
+    // (key, index) pairs are extracted into a contiguous array and ordered with sort(keys, size),
+    // then the permutation is applied in place, so every element is moved O(1) times
+    // instead of O(log(n)) and the hot loop works only with the packed keys
+
+    template <typename T, typename RandomAccessIterator, typename KeyOf, typename Sort> void index_sort(
+            const RandomAccessIterator begin,
+            const RandomAccessIterator end,
+            const KeyOf key_of,
+            const Sort sort
+    ) {
+        using key_type = std::invoke_result_t<KeyOf, const T&>;
+
+        const std::size_t size = end - begin;
+
+        if (size < 2)
+            return;
+
+        std::vector<keyed<key_type>> keys(size);
+
+        for (std::size_t i = 0; i < size; ++i)
+            keys[i] = { key_of(*(begin + i)), i };
+
+        sort(keys.data(), size);
 
-        while (mid + q != end) {
-            sort_holder[i + q] = *(mid + q);
-            ++q;
+        std::vector<std::size_t> order(size);
+
+        for (std::size_t i = 0; i < size; ++i)
+            order[i] = keys[i].index;
+
+        keys.clear();
+        keys.shrink_to_fit();
+
+        apply_permutation<T>(begin, order);
+    }
+
+    // Stable byte-wise LSD radix sort of keys in ascending order.
+    // Bytes that are the same for all keys are skipped.
+    // Complexity is O(n * bytes), memory is O(n)
+
+    inline void radix_sort(keyed<std::uint64_t>* const keys, const std::size_t size) {
+        std::vector<keyed<std::uint64_t>> buffer(size);
+        auto* src = keys;
+        auto* dst = buffer.data();
+
+        for (std::size_t shift = 0; shift < 64; shift += 8) {
+            std::size_t histogram[257] = {};
+
+            for (auto* k = src; k != src + size; ++k)
+                ++histogram[((k->key >> shift) & 0xFF) + 1];
+
+            if (std::find(histogram + 1, histogram + 257, size) != histogram + 257)
+                continue;
+
+            std::partial_sum(histogram, histogram + 257, histogram);
+
+            for (auto* k = src; k != src + size; ++k)
+                dst[histogram[(k->key >> shift) & 0xFF]++] = *k;
+
+            std::swap(src, dst);
         }
 
-        for (int step = 0; step < i + q; ++step)
-            *(begin + step) = sort_holder[step];
+        if (src != keys)
+            std::copy(src, src + size, keys);
+    }
+
+    // Sorts by count in descending order, then by string in ascending order.
+    // It is index_sort by inverted counts: they are ordered with radix_sort,
+    // then every group with the same count is sorted with multikey quicksort
+    // on cached 8-byte prefixes, so long common prefixes are not compared at every step.
+    // Complexity is O(n + total length of distinguishing prefixes) on average, memory is O(n)
+
+    template <typename T, typename RandomAccessIterator, typename Count, typename String> void frequency_sort(
+            const RandomAccessIterator begin,
+            const RandomAccessIterator end,
+            const Count count,
+            const String string
+    ) {
+        const auto string_at = [&](const std::size_t index) { return std::string_view(string(*(begin + index))); };
+
+        // Inverted counts are sorted in ascending order, so the greatest count goes first
+        const auto inverted_count = [&count](const T& elem) { return ~static_cast<std::uint64_t>(count(elem)); };
+
+        index_sort<T>(begin, end, inverted_count, [&](keyed<std::uint64_t>* const keys, const std::size_t size) {
+            radix_sort(keys, size);
+
+            std::vector<multikey::entry> entries(size);
 
-        delete[] sort_holder;
+            for (std::size_t i = 0; i < size; ++i)
+                entries[i] = { multikey::load_prefix(string_at(keys[i].index), 0), keys[i].index };
+
+            for (std::size_t group_begin = 0, group_end = 0; group_begin < size; group_begin = group_end) {
+                while (group_end < size && keys[group_end].key == keys[group_begin].key)
+                    ++group_end;
+
+                multikey::sort(entries.data() + group_begin, group_end - group_begin, 0, string_at);
+            }
+
+            // Keys are equal inside every group, so only indices are reordered
+            for (std::size_t i = 0; i < size; ++i)
+                keys[i].index = entries[i].index;
+        });
     }
 
     struct enumerated_string {
@@ -793,12 +1007,13 @@ int main() {
     std::vector<std::pair<std::string, int>> res;
     std::move(map.begin(), map.end(), std::back_inserter(res));
 
-    merge_sort<std::pair<std::string, int>>(res.begin(), res.end(), [](const auto& f, const auto& s){
-        if (f.second == s.second)
-            return f.first < s.first;
-
-        return f.second > s.second;
-    });
+    // Strings are not moved while sorting, only (prefix, index) entries are
+    frequency_sort<std::pair<std::string, int>>(
+            res.begin(),
+            res.end(),
+            [](const auto& p) { return p.second; },
+            [](const auto& p) -> const std::string& { return p.first; }
+    );
 
     for (auto [str, count] : res)
         std::cout << str << ' ' << count << std::endl;
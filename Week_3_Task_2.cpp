@@ -5,10 +5,14 @@
 #include <utility>
 #include <functional>
 #include <cstring>
+#include <cstdint>
 #include <numeric>
 #include <optional>
 #include <list>
 #include <vector>
+#include <memory>
+#include <thread>
+#include <algorithm>
 
 namespace dsa_hw {
     template <typename K, typename V> struct map {
@@ -38,23 +42,138 @@ namespace dsa_hw {
         inline bool is_empty() const { return get_size() == 0; }
     };
 
+    // Robin Hood hash map with linear probing.
+    // Capacity is a power of two, every slot remembers its distance from the home slot,
+    // richer entries (closer to home) give their place to poorer ones on insertion,
+    // so lookup stops as soon as it meets an empty slot or an entry closer to its home than the key would be.
+    // Deletion shifts the following entries back instead of leaving tombstones.
+    // One extra slot data[size] is always empty: it is end() and the result of get_if_present on miss
+
     template <typename K, typename V> class hash_map : public map<K, V> {
+        static constexpr std::size_t DEFAULT_CAPACITY = 100000;
+        static constexpr std::size_t MIN_SIZE = 8;
+
         std::size_t size;
         std::size_t elems = 0;
         std::optional<std::pair<K, V>>* data;
+        std::uint32_t* distances;
         std::function<std::size_t(const K&)> hash_algo;
 
-        inline void resize() {
-            size <<= 1;
+        // Max load factor is 3 / 4
+        static inline std::size_t get_size_for(const std::size_t capacity) {
+            std::size_t new_size = MIN_SIZE;
 
-            data = reinterpret_cast<std::optional<std::pair<K, V>>*>(
-                    std::realloc(data, size * sizeof(std::optional<std::pair<K, V>>))
-            );
+            while (new_size / 4 * 3 < capacity)
+                new_size <<= 1;
+
+            return new_size;
+        }
+
+        // User hashes may be poor in low bits (hash_string is taken modulo prime)
+        static inline std::size_t mix(std::size_t hash) {
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDULL;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+        inline std::size_t get_home(const K& key) const { return mix(hash_algo(key)) & (size - 1); }
+
+        inline void allocate(const std::size_t new_size) {
+            size = new_size;
+            data = new std::optional<std::pair<K, V>>[size + 1];
+            distances = new std::uint32_t[size]();
+        }
+
+        // Index of the key or size if it is absent
+        inline std::size_t find_index(const K& key, const std::size_t home) const {
+            const auto mask = size - 1;
+            std::uint32_t dist = 0;
+
+            for (auto index = home;; ++dist, index = (index + 1) & mask) {
+                if (!data[index].has_value() || distances[index] < dist)
+                    return size;
+
+                if (data[index]->first == key)
+                    return index;
+            }
+        }
+
+        // Places entry which is known to be absent, returns its final index
+        inline std::size_t place(std::pair<K, V>&& entry, const std::size_t home) {
+            const auto mask = size - 1;
+            auto result = size;
+            std::uint32_t dist = 0;
+
+            for (auto index = home;; ++dist, index = (index + 1) & mask) {
+                if (!data[index].has_value()) {
+                    data[index].emplace(std::move(entry));
+                    distances[index] = dist;
+                    ++elems;
+                    return result == size ? index : result;
+                }
+
+                if (distances[index] < dist) {
+                    std::swap(entry, *data[index]);
+                    std::swap(dist, distances[index]);
+
+                    if (result == size)
+                        result = index;
+                }
+            }
+        }
+
+        inline void rehash(const std::size_t new_size) {
+            auto* const old_data = data;
+            auto* const old_distances = distances;
+            const auto old_size = size;
+
+            allocate(new_size);
+            elems = 0;
+
+            for (auto* opt = old_data; opt != old_data + old_size; ++opt)
+                if (opt->has_value())
+                    place(std::move(**opt), get_home((*opt)->first));
+
+            delete[] old_data;
+            delete[] old_distances;
+        }
+
+        // Returns true if the table was rebuilt and home slots have to be recalculated
+        inline bool grow_if_not_enough_space() {
+            if (elems + 1 <= size / 4 * 3)
+                return false;
+
+            rehash(size << 1);
+            return true;
         }
 
-        inline void resize_if_not_enough_space() {
-            if (elems == size)
-                resize();
+        inline std::size_t insert_or_find(const K& key) {
+            auto home = get_home(key);
+            const auto index = find_index(key, home);
+
+            if (index != size)
+                return index;
+
+            if (grow_if_not_enough_space())
+                home = get_home(key);
+
+            return place(std::make_pair(key, V()), home);
+        }
+
+        inline void assign(std::pair<K, V>&& entry) {
+            auto home = get_home(entry.first);
+            const auto index = find_index(entry.first, home);
+
+            if (index != size) {
+                data[index]->second = std::move(entry.second);
+                return;
+            }
+
+            if (grow_if_not_enough_space())
+                home = get_home(entry.first);
+
+            place(std::move(entry), home);
         }
 
     public:
@@ -119,138 +238,28 @@ namespace dsa_hw {
         };
 
         hash_map(const std::size_t initial_capacity, std::function<std::size_t(const K&)> hash_algo) {
-            size = initial_capacity > 0 ? initial_capacity : 100000;
-
-            data = reinterpret_cast<std::optional<std::pair<K, V>>*>(
-                    std::calloc(size, sizeof(std::optional<std::pair<K, V>>))
-            );
-
-            for (auto* opt = data; opt != data + size; ++opt)
-                *opt = std::nullopt;
-
-            this->hash_algo = hash_algo;
-        }
-
-        hash_map(std::function<std::size_t(const K&)> hash_algo) {
-            size = 100000;
-
-            data = reinterpret_cast<std::optional<std::pair<K, V>>*>(
-                    std::calloc(size, sizeof(std::optional<std::pair<K, V>>))
-            );
-
-            for (auto* opt = data; opt != data + size; ++opt)
-                *opt = std::nullopt;
-
+            allocate(get_size_for(initial_capacity > 0 ? initial_capacity : DEFAULT_CAPACITY));
             this->hash_algo = hash_algo;
         }
 
-        ~hash_map() { std::free(data); }
-
-        inline void insert(const std::pair<K, V> entry) override {
-            resize_if_not_enough_space();
-            const auto [key, value] = entry;
-            const auto hashed_ind = hash_algo(key) % size;
-
-            for (std::size_t i = 0; i < size; ++i) {
-                const auto index = (hashed_ind + i) % size;
-
-                if (data[index].has_value()) {
-                    auto map_entry = data[index].value();
-
-                    if (map_entry.first == key) {
-                        map_entry.second = value;
-                        return;
-                    }
-                } else {
-                    data[index] = std::make_optional(std::make_pair(key, value));
-                    ++elems;
-                    return;
-                }
-            }
-        }
-
-        inline void insert(std::pair<K, V>&& entry) override {
-            resize_if_not_enough_space();
-            const auto [key, value] = entry;
-            const auto hashed_ind = hash_algo(key) % size;
-
-            for (std::size_t i = 0; i < size; ++i) {
-                const auto index = (hashed_ind + i) % size;
-
-                if (data[index].has_value()) {
-                    auto map_entry = data[index].value();
-
-                    if (map_entry.first == key) {
-                        map_entry.second = value;
-                        return;
-                    }
-                } else {
-                    data[index] = std::make_optional(std::make_pair(key, value));
-                    ++elems;
-                    return;
-                }
-            }
-        }
-
-        inline void insert(const K key, const V value) override {
-            resize_if_not_enough_space();
-            const auto hashed_ind = hash_algo(key) % size;
-
-            for (std::size_t i = 0; i < size; ++i) {
-                const auto index = (hashed_ind + i) % size;
+        hash_map(std::function<std::size_t(const K&)> hash_algo) : hash_map(DEFAULT_CAPACITY, hash_algo) {}
 
-                if (data[index].has_value()) {
-                    auto entry = data[index].value();
+        hash_map(const hash_map&) = delete;
+        hash_map& operator=(const hash_map&) = delete;
 
-                    if (entry.first == key) {
-                        entry.second = value;
-                        return;
-                    }
-                } else {
-                    data[index] = std::make_optional(std::make_pair(key, value));
-                    ++elems;
-                    return;
-                }
-            }
+        ~hash_map() {
+            delete[] data;
+            delete[] distances;
         }
 
-        inline void insert(K&& key, V&& value) override {
-            resize_if_not_enough_space();
-            const auto hashed_ind = hash_algo(key) % size;
-
-            for (std::size_t i = 0; i < size; ++i) {
-                const auto index = (hashed_ind + i) % size;
+        inline void insert(const std::pair<K, V> entry) override { assign(std::pair<K, V>(entry)); }
+        inline void insert(std::pair<K, V>&& entry) override { assign(std::move(entry)); }
 
-                if (data[index].has_value()) {
-                    auto entry = data[index].value();
-
-                    if (entry.first == key) {
-                        entry.second = value;
-                        return;
-                    }
-                } else {
-                    data[index] = std::make_optional(std::make_pair(key, value));
-                    ++elems;
-                    return;
-                }
-            }
-        }
+        inline void insert(const K key, const V value) override { assign(std::make_pair(key, value)); }
+        inline void insert(K&& key, V&& value) override { assign(std::make_pair(std::move(key), std::move(value))); }
 
         inline iterator find(const K& key) {
-            const auto hashed_ind = hash_algo(key) % size;
-
-            for (std::size_t i = 0; i < size; ++i) {
-                const auto index = (hashed_ind + i) % size;
-
-                if (data[index].has_value()) {
-                    auto entry = data[index].value();
-
-                    if (entry.first == key)
-                        return iterator(data + index, data, data + size);
-                }
-            }
-
-            return end();
+            return iterator(data + find_index(key, get_home(key)), data, data + size);
         }
 
         inline std::optional<std::pair<K, V>>& get_if_present(const K& key) override {
@@ -258,60 +267,34 @@ namespace dsa_hw {
         }
 
         inline std::pair<K, V>& get(const K& key) override {
-            const auto hashed_ind = hash_algo(key) % size;
-            auto empty_index = -1;
-            auto elem_it = end();
-
-            for (std::size_t i = 0; i < size; ++i) {
-                const auto index = (hashed_ind + i) % size;
-
-                if (data[index].has_value()) {
-                    auto entry = data[index].value();
-
-                    if (entry.first == key)
-                        elem_it = iterator(data + index, data, data + size);
-                } else {
-                    if (empty_index == -1)
-                        empty_index = index;
-                }
-            }
-
-            if (empty_index == -1) {
-                resize();
-
-                for (std::size_t i = 0; i < size; ++i) {
-                    const auto index = (hashed_ind + i) % size;
-
-                    if (data[index].has_value()) {
-                        auto entry = data[hashed_ind].value();
-
-                        if (entry.first == key)
-                            elem_it = iterator(data + index, data, data + size);
-                    } else {
-                        if (empty_index == -1)
-                            empty_index = index;
-                    }
-                }
-            }
-
-            if (elem_it == end())
-                elem_it = iterator(data + empty_index, data, data + size);
-
-            if (!elem_it.ptr->has_value())
-                *elem_it.ptr = std::make_optional(std::make_pair(key, V()));
-
-            return elem_it.ptr->value();
+            // Insertion may rehash, so data must be read after it
+            const auto index = insert_or_find(key);
+            return *data[index];
         }
 
         inline bool remove(const K& key) override {
             const auto iter = find(key);
-            const auto has_value = iter->has_value();
+
+            if (!iter)
+                return false;
+
             remove(iter);
-            return has_value;
+            return true;
         }
 
+        // Backward shift: entries after the removed one move one slot closer to their homes
         inline void remove(const iterator it) {
-            *it.ptr = std::nullopt;
+            const auto mask = size - 1;
+            auto index = static_cast<std::size_t>(it.ptr - data);
+
+            for (auto next = (index + 1) & mask; data[next].has_value() && distances[next] > 0; next = (next + 1) & mask) {
+                data[index] = std::move(data[next]);
+                distances[index] = distances[next] - 1;
+                index = next;
+            }
+
+            data[index] = std::nullopt;
+            distances[index] = 0;
             --elems;
         }
 
@@ -710,47 +693,434 @@ namespace dsa_hw {
 }
 
 namespace {
-    template <typename T, typename RandomAccessIterator, typename Cmp> void merge_sort(
+    namespace natural {
+
+        // Runs shorter than that are extended with binary insertion sort
+        constexpr std::size_t MIN_MERGE = 64;
+
+        // Number of consecutive wins of one run after which merge starts galloping
+        constexpr std::size_t MIN_GALLOP = 7;
+
+        // Calculates minimal run length, such that n / min_run
+        // is a power of 2 or slightly less than it.
+        // Complexity is O(log(n))
+
+        constexpr inline std::size_t min_run_length(std::size_t n) {
+            std::size_t r = 0;
+
+            while (n >= MIN_MERGE) {
+                r |= n & 1;
+                n >>= 1;
+            }
+
+            return n + r;
+        }
+
+        // Exponential search of the first element for which predicate is false.
+        // Predicate must be true for some prefix of the range.
+        // Complexity is O(log(k)), where k is the result
+
+        template <typename RandomAccessIterator, typename Pred> std::size_t gallop(
+                const RandomAccessIterator first,
+                const std::size_t size,
+                const Pred pred
+        ) {
+            std::size_t last = 0, offset = 1;
+
+            while (offset <= size && pred(*(first + (offset - 1)))) {
+                last = offset;
+                offset <<= 1;
+            }
+
+            auto low = last, high = std::min(offset - 1, size);
+
+            while (low < high) {
+                const auto mid = low + (high - low) / 2;
+
+                if (pred(*(first + mid)))
+                    low = mid + 1;
+                else
+                    high = mid;
+            }
+
+            return low;
+        }
+
+        // Finds length of the run at the beginning of the range.
+        // Strictly descending run is reversed, so that stability is preserved.
+        // Complexity is O(run)
+
+        template <typename RandomAccessIterator, typename Cmp> std::size_t count_run(
+                const RandomAccessIterator begin,
+                const RandomAccessIterator end,
+                const Cmp cmp
+        ) {
+            if (begin + 1 == end)
+                return 1;
+
+            auto run_end = begin + 2;
+
+            if (cmp(*(begin + 1), *begin)) {
+                while (run_end != end && cmp(*run_end, *(run_end - 1)))
+                    ++run_end;
+
+                std::reverse(begin, run_end);
+            } else {
+                while (run_end != end && !cmp(*run_end, *(run_end - 1)))
+                    ++run_end;
+            }
+
+            return run_end - begin;
+        }
+
+        // Binary insertion sort of [begin, end), where [begin, sorted_end) is already sorted.
+        // Complexity is O(n * log(n)) comparisons and O(n^2) moves
+
+        template <typename RandomAccessIterator, typename Cmp> void binary_insertion_sort(
+                const RandomAccessIterator begin,
+                const RandomAccessIterator sorted_end,
+                const RandomAccessIterator end,
+                const Cmp cmp
+        ) {
+            for (auto it = sorted_end; it != end; ++it) {
+                auto pivot = std::move(*it);
+                const auto position = std::upper_bound(begin, it, pivot, cmp);
+                std::move_backward(position, it, it + 1);
+                *position = std::move(pivot);
+            }
+        }
+
+        // State of the natural merge sort: buffer, stack of pending runs
+        // and adaptive galloping threshold
+
+        template <typename T, typename RandomAccessIterator, typename Cmp> class sorter {
+            struct run {
+                std::size_t base;
+                std::size_t size;
+            };
+
+            const RandomAccessIterator begin;
+            const Cmp cmp;
+            const std::size_t capacity;
+            T* const sort_holder;
+            std::vector<run> runs;
+            std::size_t min_gallop = MIN_GALLOP;
+
+        public:
+            sorter(const RandomAccessIterator begin, const std::size_t size, const Cmp cmp) :
+                    begin(begin), cmp(cmp), capacity(size), sort_holder(std::allocator<T>().allocate(size)) {}
+
+            ~sorter() { std::allocator<T>().deallocate(sort_holder, capacity); }
+
+            // Merges runs[i] with runs[i + 1].
+            // Elements of the first run that are not greater than beginning of the second one
+            // and elements of the second run that are less than ending of the first one
+            // are already in place, so they are skipped with galloping.
+            // Then the rest of the first run is moved to the uninitialized buffer and merged forward.
+            // When one of the runs wins MIN_GALLOP times in a row, merge switches to galloping
+            // and moves whole blocks found with exponential search.
+            // Complexity is O(n + m), or O(log(n + m)) for runs that are not interleaved
+
+            void merge_at(const std::size_t i) {
+                auto [first_base, first_size] = runs[i];
+                auto [second_base, second_size] = runs[i + 1];
+
+                runs[i].size += second_size;
+                runs.erase(runs.begin() + i + 1);
+
+                const auto first = begin + first_base;
+                const auto second = begin + second_base;
+
+                // Elements of the first run that stay in place
+                const auto skipped = gallop(first, first_size, [&](const T& x) { return !cmp(*second, x); });
+                first_size -= skipped;
+
+                if (first_size == 0)
+                    return;
+
+                // Elements of the second run that stay in place
+                second_size = gallop(second, second_size, [&](const T& x) { return cmp(x, *(second - 1)); });
+
+                if (second_size == 0)
+                    return;
+
+                std::uninitialized_move(first + skipped, second, sort_holder);
+
+                std::size_t i_first = 0, i_second = 0;
+                auto dest = first + skipped;
+
+                while (i_first < first_size && i_second < second_size) {
+                    std::size_t first_wins = 0, second_wins = 0;
+
+                    // One element at a time until one of the runs starts winning consistently
+
+                    while (i_first < first_size && i_second < second_size) {
+                        if (cmp(*(second + i_second), sort_holder[i_first])) {
+                            *dest++ = std::move(*(second + i_second++));
+                            first_wins = 0;
+
+                            if (++second_wins >= min_gallop)
+                                break;
+                        } else {
+                            *dest++ = std::move(sort_holder[i_first++]);
+                            second_wins = 0;
+
+                            if (++first_wins >= min_gallop)
+                                break;
+                        }
+                    }
+
+                    // Galloping while it pays off
+
+                    while (i_first < first_size && i_second < second_size) {
+                        first_wins = gallop(sort_holder + i_first, first_size - i_first, [&](const T& x) {
+                            return !cmp(*(second + i_second), x);
+                        });
+
+                        dest = std::move(sort_holder + i_first, sort_holder + i_first + first_wins, dest);
+                        i_first += first_wins;
+
+                        if (i_first == first_size)
+                            break;
+
+                        second_wins = gallop(second + i_second, second_size - i_second, [&](const T& x) {
+                            return cmp(x, sort_holder[i_first]);
+                        });
+
+                        dest = std::move(second + i_second, second + i_second + second_wins, dest);
+                        i_second += second_wins;
+
+                        if (min_gallop > 1)
+                            --min_gallop;
+
+                        if (first_wins < MIN_GALLOP && second_wins < MIN_GALLOP)
+                            break;
+                    }
+
+                    min_gallop += 2;
+                }
+
+                // Rest of the second run is already in place
+                std::move(sort_holder + i_first, sort_holder + first_size, dest);
+                std::destroy(sort_holder, sort_holder + first_size);
+            }
+
+            // Pushes new run to the stack and merges runs until invariants hold:
+            // len[i - 2] > len[i - 1] + len[i] and len[i - 1] > len[i].
+            // It keeps the stack logarithmic and merges balanced
+
+            void push_run(const std::size_t base, const std::size_t size) {
+                runs.push_back({ base, size });
+
+                while (runs.size() > 1) {
+                    auto n = runs.size() - 2;
+
+                    if ((n > 0 && runs[n - 1].size <= runs[n].size + runs[n + 1].size)
+                            || (n > 1 && runs[n - 2].size <= runs[n - 1].size + runs[n].size)) {
+                        if (runs[n - 1].size < runs[n + 1].size)
+                            --n;
+                    } else if (runs[n].size > runs[n + 1].size) {
+                        break;
+                    }
+
+                    merge_at(n);
+                }
+            }
+
+            // Merges all pending runs
+
+            void collapse() {
+                while (runs.size() > 1) {
+                    auto n = runs.size() - 2;
+
+                    if (n > 0 && runs[n - 1].size < runs[n + 1].size)
+                        --n;
+
+                    merge_at(n);
+                }
+            }
+        };
+    }
+
+    // Adaptive stable natural merge sort (TimSort).
+    // Detects ascending and strictly descending runs,
+    // extends short runs with binary insertion sort,
+    // merges runs keeping stack invariants and uses galloping
+    // when one of the runs dominates.
+    // Complexity is O(n * log(n)), O(n) for presorted data
+
+    template <typename T, typename RandomAccessIterator, typename Cmp = std::less<T>> void natural_merge_sort(
             RandomAccessIterator begin,
             RandomAccessIterator end,
             const Cmp cmp
     ) {
-        if (begin == end || begin + 1 == end)
+        const std::size_t size = end - begin;
+
+        if (size < 2)
             return;
 
-        const auto mid = begin + (end - begin) / 2;
+        const auto min_run = natural::min_run_length(size);
+        natural::sorter<T, RandomAccessIterator, Cmp> sorter(begin, size, cmp);
+
+        for (std::size_t base = 0; base < size;) {
+            auto run_size = natural::count_run(begin + base, end, cmp);
+
+            if (run_size < min_run) {
+                const auto forced_size = std::min(min_run, size - base);
+                natural::binary_insertion_sort(begin + base, begin + base + run_size, begin + base + forced_size, cmp);
+                run_size = forced_size;
+            }
+
+            sorter.push_run(base, run_size);
+            base += run_size;
+        }
+
+        sorter.collapse();
+    }
+
+    // Ranges with size less or equal to it are sorted with the sequential natural merge sort
+    constexpr std::size_t PARALLEL_SORT_GRAIN = 1 << 14;
 
-        merge_sort<T>(begin, mid, cmp);
-        merge_sort<T>(mid, end, cmp);
+    template <typename F> void run_parts(const std::size_t parts, const F& job) {
+        std::vector<std::thread> workers;
+        workers.reserve(parts - 1);
 
-        int i = 0, q = 0;
+        for (std::size_t part = 0; part + 1 < parts; ++part)
+            workers.emplace_back(job, part);
 
-        auto* const sort_holder = new T[end - begin];
+        job(parts - 1);
 
-        while (begin + i != mid && mid + q != end) {
-            if (cmp(*(begin + i), *(mid + q))) {
-                sort_holder[i + q] = *(begin + i);
-                ++i;
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    // Number of elements of the first range placed among
+    // the first `rank` elements of their merge (merge path)
+
+    template <typename RandomAccessIterator, typename Cmp> std::size_t co_rank(
+            const std::size_t rank,
+            const RandomAccessIterator first,
+            const std::size_t first_size,
+            const RandomAccessIterator second,
+            const std::size_t second_size,
+            const Cmp cmp
+    ) {
+        std::size_t i = std::min(rank, first_size);
+        std::size_t j = rank - i;
+        std::size_t i_low = rank > second_size ? rank - second_size : 0;
+        std::size_t j_low = rank > first_size ? rank - first_size : 0;
+
+        while (true) {
+            if (i > 0 && j < second_size && cmp(*(second + j), *(first + (i - 1)))) {
+                const auto delta = (i - i_low + 1) / 2;
+                j_low = j;
+                i -= delta;
+                j += delta;
+            } else if (j > 0 && i < first_size && !cmp(*(second + (j - 1)), *(first + i))) {
+                const auto delta = (j - j_low + 1) / 2;
+                i_low = i;
+                i += delta;
+                j -= delta;
             } else {
-                sort_holder[i + q] = *(mid + q);
-                ++q;
+                return i;
             }
         }
+    }
 
-        while (begin + i != mid) {
-            sort_holder[i + q] = *(begin + i);
-            ++i;
-        }
+    // Merges two sorted ranges into the uninitialized output with move construction
 
-        while (mid + q != end) {
-            sort_holder[i + q] = *(mid + q);
-            ++q;
+    template <typename T, typename RandomAccessIterator, typename Cmp> void merge_ranges(
+            RandomAccessIterator first,
+            const RandomAccessIterator first_end,
+            RandomAccessIterator second,
+            const RandomAccessIterator second_end,
+            T* out,
+            const Cmp cmp
+    ) {
+        while (first != first_end && second != second_end)
+            std::construct_at(out++, std::move(cmp(*second, *first) ? *second++ : *first++));
+
+        out = std::uninitialized_move(first, first_end, out);
+        std::uninitialized_move(second, second_end, out);
+    }
+
+    template <typename T, typename RandomAccessIterator, typename Cmp> void parallel_merge_sort(
+            const RandomAccessIterator begin,
+            const RandomAccessIterator end,
+            const Cmp cmp,
+            T* const sort_holder,
+            const std::size_t threads,
+            const std::size_t grain
+    ) {
+        const std::size_t size = end - begin;
+
+        if (threads < 2 || size <= grain) {
+            natural_merge_sort<T>(begin, end, cmp);
+            return;
         }
 
-        for (int step = 0; step < i + q; ++step)
-            *(begin + step) = sort_holder[step];
+        const auto mid = begin + size / 2;
+        const std::size_t first_size = size / 2;
+        const std::size_t second_size = size - first_size;
+        const auto left_threads = threads / 2;
+
+        std::thread left_sorter([&] {
+            parallel_merge_sort<T>(begin, mid, cmp, sort_holder, left_threads, grain);
+        });
+
+        parallel_merge_sort<T>(mid, end, cmp, sort_holder + first_size, threads - left_threads, grain);
+        left_sorter.join();
+
+        // Every thread merges its own part of the output, borders are found with co-ranking.
+        // They are found before merging starts, since merge moves elements out of the halves
+
+        std::vector<std::size_t> first_borders(threads + 1);
+
+        for (std::size_t part = 0; part <= threads; ++part)
+            first_borders[part] = co_rank(size * part / threads, begin, first_size, mid, second_size, cmp);
+
+        run_parts(threads, [&](const std::size_t part) {
+            const auto rank_begin = size * part / threads;
+            const auto rank_end = size * (part + 1) / threads;
+            const auto i_begin = first_borders[part];
+            const auto i_end = first_borders[part + 1];
+
+            merge_ranges(
+                    begin + i_begin, begin + i_end,
+                    mid + (rank_begin - i_begin), mid + (rank_end - i_end),
+                    sort_holder + rank_begin, cmp
+            );
+        });
+
+        run_parts(threads, [&](const std::size_t part) {
+            const auto rank_begin = size * part / threads;
+            const auto rank_end = size * (part + 1) / threads;
+            std::move(sort_holder + rank_begin, sort_holder + rank_end, begin + rank_begin);
+            std::destroy(sort_holder + rank_begin, sort_holder + rank_end);
+        });
+    }
+
+    // Fork-join merge sort: halves are sorted on different threads, then merged in parallel.
+    // Ranges up to the grain are sorted with natural_merge_sort, so presorted input takes O(n).
+    // Stable, the order doesn't depend on the number of threads
+
+    template <typename T, typename RandomAccessIterator, typename Cmp> void parallel_merge_sort(
+            const RandomAccessIterator begin,
+            const RandomAccessIterator end,
+            const Cmp cmp,
+            const std::size_t grain = PARALLEL_SORT_GRAIN,
+            const std::size_t threads = std::thread::hardware_concurrency()
+    ) {
+        const std::size_t size = end - begin;
+
+        if (threads < 2 || size <= grain) {
+            natural_merge_sort<T>(begin, end, cmp);
+            return;
+        }
 
-        delete[] sort_holder;
+        auto* const sort_holder = std::allocator<T>().allocate(size);
+        parallel_merge_sort<T>(begin, end, cmp, sort_holder, threads, grain);
+        std::allocator<T>().deallocate(sort_holder, size);
     }
 
     struct enumerated_string {
@@ -811,7 +1181,7 @@ int main() {
 
     std::cout << difference_btw_1_2.size() << std::endl;
 
-    merge_sort<enumerated_string>(difference_btw_1_2.begin(), difference_btw_1_2.end(), [](const auto& f, const auto& s) {
+    parallel_merge_sort<enumerated_string>(difference_btw_1_2.begin(), difference_btw_1_2.end(), [](const auto& f, const auto& s) {
         return f.ind < s.ind;
     });
 
@@ -6,6 +6,13 @@
 #include <functional>
 #include <memory>
 #include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <bit>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 /**
  * To Alaa or one who is checking the homework:
@@ -2621,6 +2628,711 @@ namespace dsa_hw {
 			[[nodiscard]] constexpr inline std::size_t get_size() const noexcept override { return elems; }
         };
 
+        // ############################ Flat Hash Map ############################
+
+        /**
+         * Open addressing hash map in the SwissTable style.
+         * Slots are grouped by 16, every slot has one control byte:
+         * EMPTY, DELETED or 7 low bits of the key's hash (H2) if the slot is full.
+         * Lookup compares H2 with the whole group of control bytes at once
+         * (SSE2 compare and movemask), so keys are compared only for the matched slots,
+         * and stops at the first group with an empty slot. Groups are probed triangularly.
+         * Entries are stored inline in one array: a lookup usually costs
+         * one cache miss for control bytes and one for the entry.
+         * Removed slots become DELETED, unless their group has an empty slot.
+         * Load factor (with deleted slots) is 87.5%, table is rebuilt when it is reached.
+         * Insertion may invalidate iterators.
+         *
+         * @param K key's type
+         * @param V value's type
+         * @param H hasher class with overridden std::size_t operator(). By default std::hash<K> is used
+         * @param KEq key's equality checker. By default std::equal_to<K> is used
+         *
+         * -------------- Complexity --------------
+         * |  Method   | Average case | Worst case |
+         * |insert(k,v)|    O(hash)   | O(hash+n)  |
+         * | remove(k) |    O(hash)   | O(hash+n)  |
+         * |  get(k)   |    O(hash)   | O(hash+n)  |
+         * | begin()   |  O(capacity) | O(capacity)|
+         * |  end()    |    O(1)      |   O(1)     |
+         */
+
+        template <typename K, typename V, typename H = std::hash<K>, typename KEq = std::equal_to<K>> class flat_hash_map : public map<K, V> {
+            using slot_type = std::pair<K, V>;
+            using slot_allocator = std::allocator<slot_type>;
+            using slot_traits = std::allocator_traits<slot_allocator>;
+
+            constexpr static const std::size_t GROUP_WIDTH = 16;
+
+            constexpr static const std::int8_t EMPTY = -128;
+            constexpr static const std::int8_t DELETED = -2;
+
+            H hasher = H();
+            KEq key_equality_checker = KEq();
+            slot_allocator allocator = slot_allocator();
+
+            /** Number of slots, power of two and multiple of GROUP_WIDTH */
+            std::size_t capacity = 0;
+
+            std::size_t elems = 0;
+
+            /** Number of empty slots that can be filled before rebuild */
+            std::size_t growth_left = 0;
+
+            std::int8_t* ctrl = nullptr;
+            slot_type* slots = nullptr;
+
+            // --------------- Group matching ---------------
+
+            /** Control bytes of 16 slots, loaded with a single instruction */
+
+            class group {
+#if defined(__SSE2__)
+                __m128i bytes;
+
+                [[nodiscard]] inline std::uint32_t match_byte(const std::int8_t byte) const noexcept {
+                    return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(byte), bytes)));
+                }
+
+            public:
+                explicit group(const std::int8_t* const pos) noexcept :
+                        bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {}
+
+                /** @return bitmask of slots that are empty or deleted (high bit is set) */
+
+                [[nodiscard]] inline std::uint32_t match_free() const noexcept {
+                    return static_cast<std::uint32_t>(_mm_movemask_epi8(bytes));
+                }
+#else
+                const std::int8_t* bytes;
+
+                [[nodiscard]] inline std::uint32_t match_byte(const std::int8_t byte) const noexcept {
+                    std::uint32_t mask = 0;
+
+                    for (std::size_t i = 0; i < GROUP_WIDTH; ++i)
+                        mask |= static_cast<std::uint32_t>(bytes[i] == byte) << i;
+
+                    return mask;
+                }
+
+            public:
+                explicit group(const std::int8_t* const pos) noexcept : bytes(pos) {}
+
+                /** @return bitmask of slots that are empty or deleted (high bit is set) */
+
+                [[nodiscard]] inline std::uint32_t match_free() const noexcept {
+                    std::uint32_t mask = 0;
+
+                    for (std::size_t i = 0; i < GROUP_WIDTH; ++i)
+                        mask |= static_cast<std::uint32_t>(bytes[i] < 0) << i;
+
+                    return mask;
+                }
+#endif
+
+                /** @return bitmask of full slots with given H2 */
+                [[nodiscard]] inline std::uint32_t match(const std::int8_t h2) const noexcept { return match_byte(h2); }
+
+                /** @return bitmask of empty slots */
+                [[nodiscard]] inline std::uint32_t match_empty() const noexcept { return match_byte(EMPTY); }
+            };
+
+            // --------------- Hashing ---------------
+
+            /** Mixes user's hash, so that identity hashes (std::hash<int>) spread over the groups */
+
+            [[nodiscard]] inline std::size_t hash_of(const K& key) const noexcept {
+                std::uint64_t hash = hasher(key);
+                hash ^= hash >> 33;
+                hash *= 0xFF51AFD7ED558CCDULL;
+                hash ^= hash >> 33;
+                return static_cast<std::size_t>(hash);
+            }
+
+            [[nodiscard]] constexpr static inline std::size_t h1(const std::size_t hash) noexcept { return hash >> 7; }
+            [[nodiscard]] constexpr static inline std::int8_t h2(const std::size_t hash) noexcept { return static_cast<std::int8_t>(hash & 0x7F); }
+
+            [[nodiscard]] constexpr inline std::size_t groups_mask() const noexcept { return capacity / GROUP_WIDTH - 1; }
+
+            [[nodiscard]] constexpr static inline std::size_t max_load(const std::size_t capacity) noexcept {
+                return capacity - capacity / 8;
+            }
+
+            // --------------- Table management ---------------
+
+            /** Allocates table with given number of slots, all of them are empty */
+
+            inline void allocate(const std::size_t new_capacity) noexcept {
+                capacity = new_capacity;
+                ctrl = new std::int8_t[capacity];
+                std::fill(ctrl, ctrl + capacity, EMPTY);
+                slots = slot_traits::allocate(allocator, capacity);
+                growth_left = max_load(capacity) - elems;
+            }
+
+            /** Destroys all entries and frees the table */
+
+            inline void deallocate() noexcept {
+                if (ctrl == nullptr)
+                    return;
+
+                for (std::size_t i = 0; i < capacity; ++i)
+                    if (ctrl[i] >= 0)
+                        slot_traits::destroy(allocator, slots + i);
+
+                slot_traits::deallocate(allocator, slots, capacity);
+                delete[] ctrl;
+
+                ctrl = nullptr;
+                slots = nullptr;
+            }
+
+            /**
+             * Searches for the first empty or deleted slot
+             * in the probe sequence of given hash.
+             * @return index of free slot
+             */
+
+            [[nodiscard]] inline std::size_t find_free_slot(const std::size_t hash) const noexcept {
+                const auto mask = groups_mask();
+
+                for (std::size_t group_ind = h1(hash) & mask, step = 1;; group_ind = (group_ind + step++) & mask) {
+                    const auto offset = group_ind * GROUP_WIDTH;
+
+                    if (const auto free = group(ctrl + offset).match_free(); free != 0)
+                        return offset + std::countr_zero(free);
+                }
+            }
+
+            /**
+             * Moves all entries to the new table with given number of slots.
+             * Deleted slots are dropped. In total O(capacity + n * hash)
+             */
+
+            inline void rehash(const std::size_t new_capacity) noexcept {
+                auto* const old_ctrl = ctrl;
+                auto* const old_slots = slots;
+                const auto old_capacity = capacity;
+
+                allocate(new_capacity);
+
+                for (std::size_t i = 0; i < old_capacity; ++i) {
+                    if (old_ctrl[i] < 0)
+                        continue;
+
+                    const auto hash = hash_of(old_slots[i].first);
+                    const auto index = find_free_slot(hash);
+
+                    ctrl[index] = h2(hash);
+                    slot_traits::construct(allocator, slots + index, std::move(old_slots[i]));
+                    slot_traits::destroy(allocator, old_slots + i);
+                }
+
+                slot_traits::deallocate(allocator, old_slots, old_capacity);
+                delete[] old_ctrl;
+            }
+
+            /**
+             * Rebuilds the table if there are no slots to fill.
+             * If most of occupied slots are deleted, capacity is kept the same
+             */
+
+            inline void rehash_if_load_factor_reached() noexcept {
+                if (growth_left > 0)
+                    return;
+
+                rehash(elems + 1 > max_load(capacity) / 2 ? capacity << 1 : capacity);
+            }
+
+            // --------------- Probing ---------------
+
+            /**
+             * Searches for entry with given key.
+             * @return index of entry's slot or capacity if not present
+             */
+
+            [[nodiscard]] inline std::size_t find_index(const K& key, const std::size_t hash) const noexcept {
+                const auto mask = groups_mask();
+                const auto tag = h2(hash);
+
+                for (std::size_t group_ind = h1(hash) & mask, step = 1;; group_ind = (group_ind + step++) & mask) {
+                    const auto offset = group_ind * GROUP_WIDTH;
+                    const group g(ctrl + offset);
+
+                    for (auto matches = g.match(tag); matches != 0; matches &= matches - 1) {
+                        const auto index = offset + std::countr_zero(matches);
+
+                        if (key_equality_checker(slots[index].first, key))
+                            return index;
+                    }
+
+                    if (g.match_empty() != 0)
+                        return capacity;
+                }
+            }
+
+            /**
+             * Places new entry, which is known to be absent.
+             * Rebuilds the table if load factor is reached.
+             * @return index of the inserted entry
+             */
+
+            template <typename... Args> inline std::size_t insert_unchecked(const std::size_t hash, Args&&... args) noexcept {
+                auto index = find_free_slot(hash);
+
+                if (ctrl[index] == EMPTY && growth_left == 0) {
+                    rehash_if_load_factor_reached();
+                    index = find_free_slot(hash);
+                }
+
+                if (ctrl[index] == EMPTY)
+                    --growth_left;
+
+                ctrl[index] = h2(hash);
+                slot_traits::construct(allocator, slots + index, std::forward<Args>(args)...);
+                ++elems;
+                return index;
+            }
+
+            /** Inserts entry or updates present value with new one */
+
+            template <typename KArg, typename VArg> inline void insert_or_assign(KArg&& key, VArg&& value) noexcept {
+                const auto hash = hash_of(key);
+
+                if (const auto index = find_index(key, hash); index != capacity) {
+                    slots[index].second = std::forward<VArg>(value);
+                    return;
+                }
+
+                insert_unchecked(hash, std::forward<KArg>(key), std::forward<VArg>(value));
+            }
+
+        public:
+
+            // --------------- Iterators ---------------
+
+            class const_iterator;
+
+            // ############################ Iterator ############################
+
+            /** Bidirectional iterator to iterate over map's entries */
+
+            class iterator {
+            public:
+                using iterator_category = std::bidirectional_iterator_tag;
+                using difference_type = std::ptrdiff_t;
+                using value_type = std::pair<K, V>;
+                using pointer = value_type*;
+                using reference = value_type&;
+
+            private:
+                friend class flat_hash_map<K, V, H, KEq>;
+                friend class const_iterator;
+
+                /** Control byte of current slot */
+                const std::int8_t* ctrl_it;
+
+                /** Current slot */
+                pointer slot;
+
+                /** Control bytes' end */
+                const std::int8_t* ctrl_end;
+
+                iterator(const std::int8_t* const ctrl_it, const pointer slot, const std::int8_t* const ctrl_end) noexcept :
+                        ctrl_it(ctrl_it), slot(slot), ctrl_end(ctrl_end) {}
+
+                /** Moves to the first full slot starting from the current one */
+
+                inline void skip_free() noexcept {
+                    while (ctrl_it != ctrl_end && *ctrl_it < 0) {
+                        ++ctrl_it;
+                        ++slot;
+                    }
+                }
+
+            public:
+                ~iterator() noexcept = default;
+
+                // --------------- Dereference operators ---------------
+
+                inline reference operator*() const noexcept { return *slot; }
+                inline pointer operator->() const noexcept { return slot; }
+
+                // --------------- Validation operators ---------------
+
+                constexpr inline explicit operator bool() const noexcept { return ctrl_it != ctrl_end; }
+                constexpr inline bool operator!() const noexcept { return ctrl_it == ctrl_end; }
+
+                // --------------- Comparison operators ---------------
+
+                constexpr inline bool operator==(const iterator& other) const noexcept { return slot == other.slot; };
+                constexpr inline bool operator!=(const iterator& other) const noexcept { return slot != other.slot; };
+
+                constexpr inline bool operator==(const const_iterator& other) const noexcept { return slot == other.slot; };
+                constexpr inline bool operator!=(const const_iterator& other) const noexcept { return slot != other.slot; };
+
+                // --------------- Movement operators ---------------
+
+                /**
+                 * Moves iterator to the next full slot.
+                 * In worst case O(capacity). Bounds are not checked.
+                 * @return iterator to the next entry
+                 */
+
+                inline iterator operator++() noexcept {
+                    ++ctrl_it;
+                    ++slot;
+                    skip_free();
+                    return *this;
+                }
+
+                /**
+                 * Moves iterator to the previous full slot.
+                 * In worst case O(capacity). Bounds are not checked.
+                 * @return iterator to the previous entry
+                 */
+
+                inline iterator operator--() noexcept {
+                    do {
+                        --ctrl_it;
+                        --slot;
+                    } while (*ctrl_it < 0);
+
+                    return *this;
+                }
+            };
+
+            // ############################ Const Iterator ############################
+
+            /**
+             * Bidirectional iterator to iterate over map's entries.
+             * Not able to modify its value
+             */
+
+            class const_iterator {
+            public:
+                using iterator_category = std::bidirectional_iterator_tag;
+                using difference_type = std::ptrdiff_t;
+                using value_type = std::pair<K, V>;
+                using pointer = const value_type*;
+                using reference = const value_type&;
+
+            private:
+                friend class flat_hash_map<K, V, H, KEq>;
+                friend class iterator;
+
+                /** Control byte of current slot */
+                const std::int8_t* ctrl_it;
+
+                /** Current slot */
+                pointer slot;
+
+                /** Control bytes' end */
+                const std::int8_t* ctrl_end;
+
+                const_iterator(const std::int8_t* const ctrl_it, const pointer slot, const std::int8_t* const ctrl_end) noexcept :
+                        ctrl_it(ctrl_it), slot(slot), ctrl_end(ctrl_end) {}
+
+                /** Moves to the first full slot starting from the current one */
+
+                inline void skip_free() noexcept {
+                    while (ctrl_it != ctrl_end && *ctrl_it < 0) {
+                        ++ctrl_it;
+                        ++slot;
+                    }
+                }
+
+            public:
+                ~const_iterator() noexcept = default;
+
+                // --------------- Dereference operators ---------------
+
+                [[nodiscard]] inline reference operator*() const noexcept { return *slot; }
+                [[nodiscard]] inline pointer operator->() const noexcept { return slot; }
+
+                // --------------- Validation operators ---------------
+
+                [[nodiscard]] constexpr inline explicit operator bool() const noexcept { return ctrl_it != ctrl_end; }
+                [[nodiscard]] constexpr inline bool operator!() const noexcept { return ctrl_it == ctrl_end; }
+
+                // --------------- Comparison operators ---------------
+
+                [[nodiscard]] constexpr inline bool operator==(const iterator& other) const noexcept { return slot == other.slot; };
+                [[nodiscard]] constexpr inline bool operator!=(const iterator& other) const noexcept { return slot != other.slot; };
+
+                [[nodiscard]] constexpr inline bool operator==(const const_iterator& other) const noexcept { return slot == other.slot; };
+                [[nodiscard]] constexpr inline bool operator!=(const const_iterator& other) const noexcept { return slot != other.slot; };
+
+                // --------------- Movement operators ---------------
+
+                /**
+                 * Moves iterator to the next full slot.
+                 * In worst case O(capacity). Bounds are not checked.
+                 * @return iterator to the next entry
+                 */
+
+                inline const_iterator operator++() noexcept {
+                    ++ctrl_it;
+                    ++slot;
+                    skip_free();
+                    return *this;
+                }
+
+                /**
+                 * Moves iterator to the previous full slot.
+                 * In worst case O(capacity). Bounds are not checked.
+                 * @return iterator to the previous entry
+                 */
+
+                inline const_iterator operator--() noexcept {
+                    do {
+                        --ctrl_it;
+                        --slot;
+                    } while (*ctrl_it < 0);
+
+                    return *this;
+                }
+            };
+
+            // --------------- Constructors ---------------
+
+            /** Creates flat_hash_map with enough slots for given number of entries without rebuild */
+
+            explicit flat_hash_map(const std::size_t initial_capacity) noexcept {
+                std::size_t new_capacity = GROUP_WIDTH;
+
+                while (max_load(new_capacity) < initial_capacity)
+                    new_capacity <<= 1;
+
+                allocate(new_capacity);
+            }
+
+            /** Creates flat_hash_map with one group of slots */
+            flat_hash_map() noexcept : flat_hash_map(0) {}
+
+            flat_hash_map(const flat_hash_map& other) noexcept :
+                    hasher(other.hasher), key_equality_checker(other.key_equality_checker) {
+                allocate(other.capacity);
+
+                for (std::size_t i = 0; i < capacity; ++i) {
+                    if (other.ctrl[i] >= 0) {
+                        const auto hash = hash_of(other.slots[i].first);
+                        const auto index = find_free_slot(hash);
+                        ctrl[index] = h2(hash);
+                        slot_traits::construct(allocator, slots + index, other.slots[i]);
+                        --growth_left;
+                        ++elems;
+                    }
+                }
+            }
+
+            flat_hash_map(flat_hash_map&& other) noexcept :
+                    hasher(std::move(other.hasher)),
+                    key_equality_checker(std::move(other.key_equality_checker)),
+                    capacity(std::exchange(other.capacity, 0)),
+                    elems(std::exchange(other.elems, 0)),
+                    growth_left(std::exchange(other.growth_left, 0)),
+                    ctrl(std::exchange(other.ctrl, nullptr)),
+                    slots(std::exchange(other.slots, nullptr)) {
+                other.allocate(GROUP_WIDTH);
+            }
+
+            flat_hash_map& operator=(flat_hash_map other) noexcept {
+                std::swap(hasher, other.hasher);
+                std::swap(key_equality_checker, other.key_equality_checker);
+                std::swap(capacity, other.capacity);
+                std::swap(elems, other.elems);
+                std::swap(growth_left, other.growth_left);
+                std::swap(ctrl, other.ctrl);
+                std::swap(slots, other.slots);
+                return *this;
+            }
+
+            ~flat_hash_map() noexcept { deallocate(); }
+
+            // --------------- Insertions ---------------
+
+            /**
+             * Inserts element or updates present value with new one.
+             * Rebuilds the table if load factor is reached.
+             * In total O(hash strategy) in average case.
+             *
+             * @param key entry's key to insert
+             * @param value entry's value to insert
+             */
+
+            inline void insert(const K& key, const V& value) noexcept override { insert_or_assign(key, value); }
+
+            /**
+             * Inserts element or updates present value with new one.
+             * Rebuilds the table if load factor is reached.
+             * In total O(hash strategy) in average case.
+             *
+             * @param key entry's key to insert
+             * @param value entry's value to insert
+             */
+
+            inline void insert(K&& key, V&& value) noexcept override { insert_or_assign(std::move(key), std::move(value)); }
+
+            /**
+             * Inserts element or updates present entry with new one.
+             * Rebuilds the table if load factor is reached.
+             * In total O(hash strategy) in average case.
+             * @param entry key and value to insert
+             */
+
+            inline void insert(const std::pair<K, V>& entry) noexcept override { insert_or_assign(entry.first, entry.second); }
+
+            /**
+             * Inserts element or updates present entry with new one.
+             * Rebuilds the table if load factor is reached.
+             * In total O(hash strategy) in average case.
+             * @param entry key and value to insert
+             */
+
+            inline void insert(std::pair<K, V>&& entry) noexcept override {
+                insert_or_assign(std::move(entry.first), std::move(entry.second));
+            }
+
+            // --------------- Searching ---------------
+
+            /**
+             * Searches for entry with given key.
+             * In total O(hash strategy) in average case.
+             * @param key entry's key to search
+             * @return iterator to entry or end iterator if not present
+             */
+
+            [[nodiscard]] inline iterator find(const K& key) noexcept {
+                const auto index = find_index(key, hash_of(key));
+                return iterator(ctrl + index, slots + index, ctrl + capacity);
+            }
+
+            /**
+             * Searches for entry with given key.
+             * In total O(hash strategy) in average case.
+             * @param key entry's key to search
+             * @return iterator to entry or end iterator if not present
+             */
+
+            [[nodiscard]] inline const_iterator find(const K& key) const noexcept {
+                const auto index = find_index(key, hash_of(key));
+                return const_iterator(ctrl + index, slots + index, ctrl + capacity);
+            }
+
+            /**
+             * Gets entry with given key or creates
+             * with default value if not present.
+             * In total O(hash strategy) in average case.
+             * @param key entry's key to search
+             * @return reference to value
+             */
+
+            inline V& operator[] (const K& key) noexcept override {
+                const auto hash = hash_of(key);
+                auto index = find_index(key, hash);
+
+                if (index == capacity)
+                    index = insert_unchecked(hash, key, V());
+
+                return slots[index].second;
+            }
+
+            // --------------- Removing ---------------
+
+            /**
+             * Removes entry with given key.
+             * In total O(hash strategy) in average case.
+             * @param key entry's key to search
+             * @return true if value was removed
+             */
+
+            inline bool remove(const K& key) noexcept override {
+                const auto iter = find(key);
+
+                if (iter == end())
+                    return false;
+
+                remove(iter);
+                return true;
+            }
+
+            /**
+             * Removes entry by iterator.
+             * If the slot's group has an empty slot, no probe sequence
+             * passes through it, so slot becomes empty instead of deleted.
+             * In total O(1) in all cases
+             * @param iter entry's iterator
+             */
+
+            inline void remove(const iterator iter) noexcept {
+                const auto index = static_cast<std::size_t>(iter.slot - slots);
+                slot_traits::destroy(allocator, iter.slot);
+
+                if (group(ctrl + index / GROUP_WIDTH * GROUP_WIDTH).match_empty() != 0) {
+                    ctrl[index] = EMPTY;
+                    ++growth_left;
+                } else {
+                    ctrl[index] = DELETED;
+                }
+
+                --elems;
+            }
+
+            // --------------- Iterators ---------------
+
+            /**
+             * Gets iterator to the first entry, if present.
+             * In worst case O(capacity).
+             * @return iterator to the first entry or end iterator
+             * if there are no elements in map
+             */
+
+            [[nodiscard]] inline iterator begin() noexcept {
+                iterator it(ctrl, slots, ctrl + capacity);
+                it.skip_free();
+                return it;
+            }
+
+            /**
+             * Gets iterator to the first entry, if present.
+             * In worst case O(capacity).
+             * @return iterator to the first entry or end iterator
+             * if there are no elements in map
+             */
+
+            [[nodiscard]] inline const_iterator begin() const noexcept {
+                const_iterator it(ctrl, slots, ctrl + capacity);
+                it.skip_free();
+                return it;
+            }
+
+            /**
+             * Gets last iterator that is out of bounds
+             * and does not have a value. Equality to this iterator
+             * means end of map.
+             * @return out of bounds iterator
+             */
+
+            [[nodiscard]] constexpr inline iterator end() noexcept {
+                return iterator(ctrl + capacity, slots + capacity, ctrl + capacity);
+            }
+
+            /**
+             * Gets last iterator that is out of bounds
+             * and does not have a value. Equality to this iterator
+             * means end of map.
+             * @return out of bounds iterator
+             */
+
+            [[nodiscard]] constexpr inline const_iterator end() const noexcept {
+                return const_iterator(ctrl + capacity, slots + capacity, ctrl + capacity);
+            }
+
+            /** Gets current number of elements in map */
+            [[nodiscard]] constexpr inline std::size_t get_size() const noexcept override { return elems; }
+        };
+
 		// ############################ Set ADL ############################
 
 		/**
@@ -2,8 +2,20 @@
 
 #include <cstdio>
 #include <cstdint>
-#include <ranges>
 #include <vector>
+#include <array>
+#include <tuple>
+#include <bit>
+#include <iterator>
+#include <type_traits>
+#include <algorithm>
+#include <utility>
+#include <set>
+#include <optional>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <barrier>
 
 // --------------------- GIGACHAD SORT ---------------------
 //⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⣀⣤⣤⣤⣶⣤⣤⣀⣀⣀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀
@@ -35,43 +47,532 @@
 //⠯⠀⠀⠀⠒⠀⠀⠀⠀⠀⠐⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⢻⣿⣿⣷⣄⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⢸⣿⡄⠈⠳⠀⠀⠀⠀
 //⠀⠀⢀⣀⣀⡀⣼⣤⡟⣬⣿⣷⣤⣀⣄⣀⡀⠀⠀⠀⠀⠀⠀⠈⣿⣿⡄⣉⡀⠀⠀⠀⠀⠀⠀⠀⢀⠀⠀⠀⠀⠀⣿⣿⣄⠀⣀⣀⡀
 // ---------------------------------------------------------
-// For this task we will slightly modify idea of Counting Sort.
-// We will hold elements in 3D array, where 1D - current bids, 2D -
-// maximal bids, 3D - indices.
+// For this task we will use Counting Sort in LSD (least significant digit) order.
+// Bids are composite keys (cur_bid, max_bid), so firstly bids are sorted
+// by maximal bids in ascending order, then by current bids in descending order.
+// Counting sort is stable, so after the second pass bids with the same current bid
+// are still ordered by maximal bid, then by index in input.
 //
-// So, with given bids we are able to access indices with such elements.
-// Instead of counting, we will put indices of elems to make it stable.
-// Finally, we can iterate through this 3D array and construct (or in our
-// case just print) elements by given parameters.
+// Sort is generalized in dsa_hw::multi_key_sort: every key has compile-time range
+// and direction, adjacent keys with small ranges are packed into one digit,
+// all passes reuse one flat histogram, so memory is O(n + key range)
 //
-// All in all, we have overcome the main problem of counting sort
-// (recreation of data structure) by introducing all parameters in our array
+// For bids that arrive continuously dsa_hw::ranking_index keeps them bucketed
+// by current bid, so ranking is available at any moment without re-sorting.
+// It is a library addition: main gets the whole batch at once, so it is sorted
 // ---------------------------------------------------------
 
+namespace dsa_hw {
+
+	/** Direction in which key is sorted */
+	enum class sort_order { ASCENDING, DESCENDING };
+
+	/**
+	 * Key for the multi-key sort with values in [Min, Max].
+	 * Maps extracted value to the digit in [0, RANGE),
+	 * so that digits are always sorted in ascending order.
+	 *
+	 * @param Min minimal value of the key
+	 * @param Max maximal value of the key
+	 * @param Order direction in which key is sorted
+	 * @param Extractor function that extracts key from the element
+	 */
+
+	template <std::int64_t Min, std::int64_t Max, sort_order Order, typename Extractor> struct sort_key {
+		static_assert(Min <= Max, "Key range is empty");
+
+		static constexpr std::uint64_t RANGE = static_cast<std::uint64_t>(Max - Min) + 1;
+
+		Extractor extractor;
+
+		/**
+		 * Gets digit of the element for this key.
+		 * Complexity depends on extractor
+		 * @return value in [0, RANGE)
+		 */
+
+		template <typename T> [[nodiscard]] constexpr inline std::uint64_t digit(const T& elem) const noexcept {
+			const auto value = static_cast<std::uint64_t>(static_cast<std::int64_t>(extractor(elem)) - Min);
+			return Order == sort_order::ASCENDING ? value : RANGE - 1 - value;
+		}
+	};
+
+	/**
+	 * Creates key for the multi-key sort
+	 * @param extractor function that extracts key from the element
+	 */
+
+	template <std::int64_t Min, std::int64_t Max, sort_order Order = sort_order::ASCENDING, typename Extractor>
+	[[nodiscard]] constexpr inline sort_key<Min, Max, Order, Extractor> make_sort_key(Extractor extractor) noexcept {
+		return { extractor };
+	}
+
+	namespace multi_key {
+
+		/** Maximal number of buckets in one counting sort pass */
+		constexpr std::uint64_t MAX_DIGIT_RANGE = 1 << 20;
+
+		/**
+		 * Layout of digits: digit d consists of keys [borders[d], borders[d + 1]).
+		 * Adjacent keys are packed into one digit while product of their ranges
+		 * does not exceed MAX_DIGIT_RANGE. If any key is wider than that,
+		 * layout is not countable and comparison sort is used
+		 */
+
+		template <std::size_t N> struct layout {
+			std::array<std::size_t, N + 1> borders {};
+			std::array<std::uint64_t, N> ranges {};
+			std::size_t digits = 0;
+			std::uint64_t total_range = 0;
+			bool is_countable = true;
+		};
+
+		template <std::size_t N> [[nodiscard]] constexpr layout<N> make_layout(
+				const std::array<std::uint64_t, N>& key_ranges
+		) noexcept {
+			layout<N> result;
+
+			for (std::size_t key = 0; key < N; ++key) {
+				if (key_ranges[key] > MAX_DIGIT_RANGE) {
+					result.is_countable = false;
+					return result;
+				}
+
+				if (result.digits > 0 && result.ranges[result.digits - 1] * key_ranges[key] <= MAX_DIGIT_RANGE) {
+					result.ranges[result.digits - 1] *= key_ranges[key];
+				} else {
+					result.borders[result.digits] = key;
+					result.ranges[result.digits++] = key_ranges[key];
+				}
+			}
+
+			result.borders[result.digits] = N;
+
+			for (std::size_t digit = 0; digit < result.digits; ++digit)
+				result.total_range += result.ranges[digit];
+
+			return result;
+		}
+
+		/**
+		 * Calculates mixed-radix digit of keys [First, Last) for the element.
+		 * Complexity is O(Last - First)
+		 */
+
+		template <std::size_t First, std::size_t Last, typename T, typename... Keys>
+		[[nodiscard]] inline std::uint64_t digit(const T& elem, const std::tuple<Keys...>& keys) noexcept {
+			return [&]<std::size_t... I>(std::index_sequence<I...>) {
+				std::uint64_t value = 0;
+				((value = value * std::remove_cvref_t<std::tuple_element_t<First + I, std::tuple<Keys...>>>::RANGE
+						+ std::get<First + I>(keys).digit(elem)), ...);
+				return value;
+			}(std::make_index_sequence<Last - First>());
+		}
+
+		/**
+		 * Stable counting sort pass from src to dst by digit in [0, range).
+		 * Histogram must have at least range elements.
+		 * Complexity is O(n + range)
+		 */
+
+		template <typename InputIterator, typename OutputIterator, typename Digit> void counting_sort_pass(
+				const InputIterator src,
+				const std::size_t size,
+				const OutputIterator dst,
+				const Digit digit,
+				const std::uint64_t range,
+				std::size_t* const histogram
+		) noexcept {
+			std::fill(histogram, histogram + range, 0);
+
+			for (auto elem = src; elem != src + size; ++elem)
+				++histogram[digit(*elem)];
+
+			// Prefix sums: histogram[d] is the position of the first element with digit d
+			std::size_t offset = 0;
+
+			for (auto* counter = histogram; counter != histogram + range; ++counter)
+				offset += std::exchange(*counter, offset);
+
+			for (auto elem = src; elem != src + size; ++elem)
+				*(dst + histogram[digit(*elem)]++) = std::move(*elem);
+		}
+
+		/** Minimal number of elements counted by one thread */
+		constexpr std::size_t PARALLEL_COUNTING_GRAIN = 1 << 16;
+
+		/**
+		 * Parallel version of counting_sort_pass. Input is split into equal chunks,
+		 * every thread counts digits of its chunk into its own histogram.
+		 * Offsets are prefix sums in (digit, thread) order, so elements with the same digit
+		 * are placed in chunk order and the pass is still stable and deterministic.
+		 * Prefix sums are parallel too: threads sum disjoint blocks of digits,
+		 * then every block is shifted by the sums of previous ones.
+		 * Finally, every thread scatters its chunk with its own offsets.
+		 * Threads are started once per pass, phases are separated with barriers.
+		 * Histograms must have at least threads * range elements.
+		 * Complexity is O((n + range * threads) / threads)
+		 */
+
+		template <typename InputIterator, typename OutputIterator, typename Digit> void parallel_counting_sort_pass(
+				const InputIterator src,
+				const std::size_t size,
+				const OutputIterator dst,
+				const Digit digit,
+				const std::uint64_t range,
+				std::size_t* const histograms,
+				const std::size_t threads
+		) noexcept {
+			// block_offsets[part] is the position of the first element with digit from the part's block
+			std::vector<std::size_t> block_offsets(threads + 1);
+
+			std::barrier phase_done(static_cast<std::ptrdiff_t>(threads));
+
+			// Block sums are turned into offsets by the last thread reaching the barrier
+			std::barrier blocks_summed(static_cast<std::ptrdiff_t>(threads), [&]() noexcept {
+				std::partial_sum(block_offsets.begin(), block_offsets.end(), block_offsets.begin());
+			});
+
+			const auto job = [&](const std::size_t part) {
+				auto* const histogram = histograms + part * range;
+				const auto chunk_begin = src + size * part / threads;
+				const auto chunk_end = src + size * (part + 1) / threads;
+				const auto block_begin = range * part / threads;
+				const auto block_end = range * (part + 1) / threads;
+
+				std::fill(histogram, histogram + range, 0);
+
+				for (auto elem = chunk_begin; elem != chunk_end; ++elem)
+					++histogram[digit(*elem)];
+
+				phase_done.arrive_and_wait();
+
+				std::size_t sum = 0;
+
+				for (auto d = block_begin; d < block_end; ++d)
+					for (std::size_t thread = 0; thread < threads; ++thread)
+						sum += histograms[thread * range + d];
+
+				block_offsets[part + 1] = sum;
+				blocks_summed.arrive_and_wait();
+
+				auto offset = block_offsets[part];
+
+				for (auto d = block_begin; d < block_end; ++d)
+					for (std::size_t thread = 0; thread < threads; ++thread)
+						offset += std::exchange(histograms[thread * range + d], offset);
+
+				phase_done.arrive_and_wait();
+
+				for (auto elem = chunk_begin; elem != chunk_end; ++elem)
+					*(dst + histogram[digit(*elem)]++) = std::move(*elem);
+			};
+
+			std::vector<std::thread> workers;
+			workers.reserve(threads - 1);
+
+			for (std::size_t part = 0; part + 1 < threads; ++part)
+				workers.emplace_back(job, part);
+
+			job(threads - 1);
+
+			for (auto& worker : workers)
+				worker.join();
+		}
+	}
+
+	/**
+	 * Stable sort by several keys, the first key is the most significant.
+	 * Digit layout is chosen at compile time from key ranges (see multi_key::layout),
+	 * then digits are sorted with counting sort from the least significant one (LSD).
+	 * Ranges that are too wide, as well as ranges much bigger than the input,
+	 * are sorted with stable comparison sort instead.
+	 * Counting passes are split between threads (see multi_key::parallel_counting_sort_pass),
+	 * result does not depend on the number of threads.
+	 * Complexity is O(digits * (n + range * threads) / threads) or O(n * log(n) * keys)
+	 *
+	 * @param begin iterator to the beginning of the collection
+	 * @param end iterator to the end of the collection
+	 * @param threads maximal number of threads
+	 * @param keys keys created with make_sort_key
+	 */
+
+	template <typename RandomAccessIterator, typename... Keys> void parallel_multi_key_sort(
+			const RandomAccessIterator begin,
+			const RandomAccessIterator end,
+			std::size_t threads,
+			const Keys&... keys
+	) noexcept {
+		using T = std::iter_value_t<RandomAccessIterator>;
+		static constexpr auto LAYOUT = multi_key::make_layout<sizeof...(Keys)>({ Keys::RANGE... });
+
+		const std::size_t size = end - begin;
+		const auto keys_tuple = std::tie(keys...);
+
+		if constexpr (!LAYOUT.is_countable) {
+			std::stable_sort(begin, end, [&keys...](const T& a, const T& b) {
+				return std::make_tuple(keys.digit(a)...) < std::make_tuple(keys.digit(b)...);
+			});
+		} else {
+			// Histograms would be scanned longer than input is sorted with comparisons
+			if (size * std::bit_width(size) < LAYOUT.total_range) {
+				std::stable_sort(begin, end, [&keys...](const T& a, const T& b) {
+					return std::make_tuple(keys.digit(a)...) < std::make_tuple(keys.digit(b)...);
+				});
+				return;
+			}
+
+			// Every thread must count at least PARALLEL_COUNTING_GRAIN elements
+			threads = std::clamp<std::size_t>(size / multi_key::PARALLEL_COUNTING_GRAIN, 1, std::max<std::size_t>(threads, 1));
+
+			std::vector<T> sort_holder(size);
+			std::vector<std::size_t> histogram(threads * *std::max_element(LAYOUT.ranges.begin(), LAYOUT.ranges.begin() + LAYOUT.digits));
+			bool is_in_holder = false;
+
+			// Passes from the least significant digit to the most significant one
+			[&]<std::size_t... D>(std::index_sequence<D...>) {
+				([&] {
+					constexpr auto DIGIT = LAYOUT.digits - 1 - D;
+					const auto digit = [&keys_tuple](const T& elem) {
+						return multi_key::digit<LAYOUT.borders[DIGIT], LAYOUT.borders[DIGIT + 1]>(elem, keys_tuple);
+					};
+
+					const auto pass = [&](const auto src, const auto dst) {
+						if (threads > 1)
+							multi_key::parallel_counting_sort_pass(src, size, dst, digit, LAYOUT.ranges[DIGIT], histogram.data(), threads);
+						else
+							multi_key::counting_sort_pass(src, size, dst, digit, LAYOUT.ranges[DIGIT], histogram.data());
+					};
+
+					if (is_in_holder)
+						pass(sort_holder.begin(), begin);
+					else
+						pass(begin, sort_holder.begin());
+
+					is_in_holder = !is_in_holder;
+				}(), ...);
+			}(std::make_index_sequence<LAYOUT.digits>());
+
+			if (is_in_holder)
+				std::move(sort_holder.begin(), sort_holder.end(), begin);
+		}
+	}
+
+	/**
+	 * Stable sort by several keys in the calling thread,
+	 * see parallel_multi_key_sort for details.
+	 * Complexity is O(digits * (n + range)) or O(n * log(n) * keys)
+	 *
+	 * @param begin iterator to the beginning of the collection
+	 * @param end iterator to the end of the collection
+	 * @param keys keys created with make_sort_key
+	 */
+
+	template <typename RandomAccessIterator, typename... Keys> inline void multi_key_sort(
+			const RandomAccessIterator begin,
+			const RandomAccessIterator end,
+			const Keys&... keys
+	) noexcept { parallel_multi_key_sort(begin, end, 1, keys...); }
+
+	/**
+	 * Online ranking of elements by two keys created with make_sort_key.
+	 * Elements are bucketed by the digit of the primary key (its range must be small),
+	 * every bucket keeps ordered set of (secondary digit, insertion order, id) entries.
+	 * Equal keys are ordered by insertion, so ranking is the same
+	 * as stable multi_key_sort of elements in insertion order produces.
+	 * Ids of removed elements are reused, so memory is O(live elements).
+	 * Non-empty buckets are marked in a bitset, so empty ones are skipped by words.
+	 *
+	 * @param T type of elements
+	 * @param PrimaryKey the most significant key
+	 * @param SecondaryKey key which orders elements with the same primary key
+	 */
+
+	template <typename T, typename PrimaryKey, typename SecondaryKey> class ranking_index {
+		static_assert(PrimaryKey::RANGE <= multi_key::MAX_DIGIT_RANGE, "Primary key range is too wide for buckets");
+
+		using entry = std::tuple<std::uint64_t, std::uint64_t, std::size_t>;
+
+		struct slot {
+			T elem;
+			std::uint64_t order;
+		};
+
+		static constexpr std::size_t WORD_BITS = 64;
+
+		PrimaryKey primary;
+		SecondaryKey secondary;
+
+		std::vector<std::set<entry>> buckets = std::vector<std::set<entry>>(PrimaryKey::RANGE);
+		std::vector<std::uint64_t> non_empty = std::vector<std::uint64_t>((PrimaryKey::RANGE + WORD_BITS - 1) / WORD_BITS);
+
+		// Element by its id, removed elements are empty
+		std::vector<std::optional<slot>> elements;
+
+		// Ids of removed elements, given to the next inserted ones
+		std::vector<std::size_t> free_ids;
+
+		std::uint64_t next_order = 0;
+		std::size_t size = 0;
+
+		inline void link(const std::size_t id) {
+			const auto& [elem, order] = *elements[id];
+			const auto bucket = primary.digit(elem);
+			buckets[bucket].emplace(secondary.digit(elem), order, id);
+			non_empty[bucket / WORD_BITS] |= std::uint64_t(1) << (bucket % WORD_BITS);
+		}
+
+		inline void unlink(const std::size_t id) noexcept {
+			const auto& [elem, order] = *elements[id];
+			const auto bucket = primary.digit(elem);
+			buckets[bucket].erase(entry(secondary.digit(elem), order, id));
+
+			if (buckets[bucket].empty())
+				non_empty[bucket / WORD_BITS] &= ~(std::uint64_t(1) << (bucket % WORD_BITS));
+		}
+
+	public:
+		ranking_index(PrimaryKey primary, SecondaryKey secondary) : primary(primary), secondary(secondary) {}
+
+		/**
+		 * Adds element to the ranking.
+		 * Complexity is O(log(n))
+		 * @return id of the element, which is used to update or remove it (ids of removed elements are reused)
+		 */
+		std::size_t insert(T elem) {
+			std::size_t id = elements.size();
+
+			if (free_ids.empty()) {
+				elements.emplace_back();
+			} else {
+				id = free_ids.back();
+				free_ids.pop_back();
+			}
+
+			elements[id].emplace(std::move(elem), next_order++);
+			link(id);
+			++size;
+			return id;
+		}
+
+		/**
+		 * Removes element from the ranking.
+		 * Complexity is O(log(n))
+		 * @return false if there is no element with such id
+		 */
+		bool remove(const std::size_t id) noexcept {
+			if (id >= elements.size() || !elements[id].has_value())
+				return false;
+
+			unlink(id);
+			elements[id].reset();
+			free_ids.push_back(id);
+			--size;
+			return true;
+		}
+
+		/**
+		 * Replaces element keeping its id, so its position
+		 * among elements with equal keys is not changed.
+		 * Complexity is O(log(n))
+		 * @return false if there is no element with such id
+		 */
+		bool update(const std::size_t id, T elem) {
+			if (id >= elements.size() || !elements[id].has_value())
+				return false;
+
+			unlink(id);
+			elements[id]->elem = std::move(elem);
+			link(id);
+			return true;
+		}
+
+		/**
+		 * Calls action for the first limit elements of the ranking in order.
+		 * Complexity is O(limit + range / 64)
+		 * @param action function called with id and element
+		 * @param limit maximal number of elements to visit
+		 */
+		template <typename Action> void for_each(
+				const Action action,
+				std::size_t limit = std::numeric_limits<std::size_t>::max()
+		) const {
+			for (std::size_t word = 0; word < non_empty.size(); ++word) {
+				for (auto bits = non_empty[word]; bits != 0; bits &= bits - 1) {
+					const auto bucket = word * WORD_BITS + std::countr_zero(bits);
+
+					for (const auto& [_, order, id] : buckets[bucket]) {
+						if (limit-- == 0)
+							return;
+
+						action(id, elements[id]->elem);
+					}
+				}
+			}
+		}
+
+		/**
+		 * Gets element by its id.
+		 * Complexity is O(1)
+		 * @return pointer to the element or nullptr if it was removed
+		 */
+		[[nodiscard]] inline const T* get(const std::size_t id) const noexcept {
+			return id < elements.size() && elements[id].has_value() ? &elements[id]->elem : nullptr;
+		}
+
+		[[nodiscard]] inline std::size_t get_size() const noexcept { return size; }
+
+		[[nodiscard]] inline bool is_empty() const noexcept { return size == 0; }
+	};
+
+	/**
+	 * Creates online ranking of elements by keys created with make_sort_key
+	 * @param primary the most significant key
+	 * @param secondary key which orders elements with the same primary key
+	 */
+
+	template <typename T, typename PrimaryKey, typename SecondaryKey>
+	[[nodiscard]] inline ranking_index<T, PrimaryKey, SecondaryKey> make_ranking_index(
+			PrimaryKey primary,
+			SecondaryKey secondary
+	) {
+		return { primary, secondary };
+	}
+}
+
+constexpr std::uint32_t MAX_CUR_BID = 100;
+constexpr std::uint32_t MAX_MAX_BID = 100000;
+
+struct bid {
+	std::uint32_t cur_bid = 0;
+	std::uint32_t max_bid = 0;
+	std::uint32_t index = 0;
+};
+
 int main() {
 	std::uint32_t n = 0;
 	std::scanf("%u", &n);
 
-	// Gigachad vector to insert indices of elements
-	std::vector<std::vector<std::vector<std::uint32_t>>> gigachad_sort_vec(101,
-			std::vector<std::vector<std::uint32_t>>(100001)
-	);
-
-	for (int i = 0; i < n; ++i) {
-		std::uint32_t cur_bid = 0, max_bid = 0;
-		std::scanf("%u%u", &cur_bid, &max_bid);
+	std::vector<bid> bids(n);
 
-		// Adding index to the given element
-		gigachad_sort_vec[cur_bid][max_bid].push_back(i);
+	for (std::uint32_t i = 0; i < n; ++i) {
+		std::scanf("%u%u", &bids[i].cur_bid, &bids[i].max_bid);
+		bids[i].index = i;
 	}
 
-	// After sorting, we can iterate and reconstruct elements
-	// In our case we just have to print index
+	// Current bids in descending order, then maximal bids in ascending order.
+	// Sort is stable, so equal bids are left in input order (with any number of threads)
+
+	dsa_hw::parallel_multi_key_sort(
+			bids.begin(),
+			bids.end(),
+			std::thread::hardware_concurrency(),
+			dsa_hw::make_sort_key<0, MAX_CUR_BID, dsa_hw::sort_order::DESCENDING>([](const bid& b) { return b.cur_bid; }),
+			dsa_hw::make_sort_key<0, MAX_MAX_BID>([](const bid& b) { return b.max_bid; })
+	);
 
-	for (const auto& cur_bids : std::ranges::reverse_view(gigachad_sort_vec))
-		for (const auto& max_bids : cur_bids)
-			for (const auto& index : max_bids)
-				std::printf("%u ", index + 1);
+	for (const auto& b : bids)
+		std::printf("%u ", b.index + 1);
 
 	return 0;
 }
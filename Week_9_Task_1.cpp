@@ -3,6 +3,8 @@
 #include <iostream>
 #include <vector>
 #include <memory>
+#include <thread>
+#include <algorithm>
 
 #pragma GCC optimize("Ofast")
 #pragma GCC optimize("O3")
@@ -22,57 +24,540 @@
 
 namespace dsa_hw {
 
+	// ############################### Natural Merge Sort ###############################
+
+	namespace natural {
+
+		/** Runs shorter than that are extended with binary insertion sort */
+		constexpr std::size_t MIN_MERGE = 64;
+
+		/** Number of consecutive wins of one run after which merge starts galloping */
+		constexpr std::size_t MIN_GALLOP = 7;
+
+		/**
+		 * Calculates minimal run length, such that n / min_run
+		 * is a power of 2 or slightly less than it.
+		 * Complexity is O(log(n))
+		 */
+
+		[[nodiscard]] constexpr inline std::size_t min_run_length(std::size_t n) noexcept {
+			std::size_t r = 0;
+
+			while (n >= MIN_MERGE) {
+				r |= n & 1;
+				n >>= 1;
+			}
+
+			return n + r;
+		}
+
+		/**
+		 * Exponential search of the first element for which predicate is false.
+		 * Predicate must be true for some prefix of the range.
+		 * Complexity is O(log(k)), where k is the result
+		 *
+		 * @param first iterator to the beginning of the range
+		 * @param size size of the range
+		 * @param pred predicate that is true for the prefix
+		 * @return length of the prefix
+		 */
+
+		template <typename RandomAccessIterator, typename Pred> [[nodiscard]] std::size_t gallop(
+				const RandomAccessIterator first,
+				const std::size_t size,
+				const Pred pred
+		) noexcept {
+			std::size_t last = 0, offset = 1;
+
+			while (offset <= size && pred(*(first + (offset - 1)))) {
+				last = offset;
+				offset <<= 1;
+			}
+
+			auto low = last, high = std::min(offset - 1, size);
+
+			while (low < high) {
+				const auto mid = low + (high - low) / 2;
+
+				if (pred(*(first + mid)))
+					low = mid + 1;
+				else
+					high = mid;
+			}
+
+			return low;
+		}
+
+		/**
+		 * Finds length of the run at the beginning of the range.
+		 * Strictly descending run is reversed, so that stability is preserved.
+		 * Complexity is O(run)
+		 */
+
+		template <typename RandomAccessIterator, typename Cmp> [[nodiscard]] std::size_t count_run(
+				const RandomAccessIterator begin,
+				const RandomAccessIterator end,
+				const Cmp cmp
+		) noexcept {
+			if (begin + 1 == end)
+				return 1;
+
+			auto run_end = begin + 2;
+
+			if (cmp(*(begin + 1), *begin)) {
+				while (run_end != end && cmp(*run_end, *(run_end - 1)))
+					++run_end;
+
+				std::reverse(begin, run_end);
+			} else {
+				while (run_end != end && !cmp(*run_end, *(run_end - 1)))
+					++run_end;
+			}
+
+			return run_end - begin;
+		}
+
+		/**
+		 * Binary insertion sort of [begin, end), where [begin, sorted_end) is already sorted.
+		 * Complexity is O(n * log(n)) comparisons and O(n^2) moves
+		 */
+
+		template <typename RandomAccessIterator, typename Cmp> void binary_insertion_sort(
+				const RandomAccessIterator begin,
+				const RandomAccessIterator sorted_end,
+				const RandomAccessIterator end,
+				const Cmp cmp
+		) noexcept {
+			for (auto it = sorted_end; it != end; ++it) {
+				auto pivot = std::move(*it);
+				const auto position = std::upper_bound(begin, it, pivot, cmp);
+				std::move_backward(position, it, it + 1);
+				*position = std::move(pivot);
+			}
+		}
+
+		/**
+		 * State of the natural merge sort: buffer, stack of pending runs
+		 * and adaptive galloping threshold
+		 */
+
+		template <typename T, typename RandomAccessIterator, typename Cmp> class sorter {
+			struct run {
+				std::size_t base;
+				std::size_t size;
+			};
+
+			const RandomAccessIterator begin;
+			const Cmp cmp;
+			const std::size_t capacity;
+			T* const sort_holder;
+			std::vector<run> runs;
+			std::size_t min_gallop = MIN_GALLOP;
+
+		public:
+			sorter(const RandomAccessIterator begin, const std::size_t size, const Cmp cmp) noexcept :
+					begin(begin), cmp(cmp), capacity(size), sort_holder(std::allocator<T>().allocate(size)) {}
+
+			~sorter() noexcept { std::allocator<T>().deallocate(sort_holder, capacity); }
+
+			/**
+			 * Merges runs[i] with runs[i + 1].
+			 * Elements of the first run that are not greater than beginning of the second one
+			 * and elements of the second run that are less than ending of the first one
+			 * are already in place, so they are skipped with galloping.
+			 * Then the rest of the first run is moved to the uninitialized buffer and merged forward.
+			 * When one of the runs wins MIN_GALLOP times in a row, merge switches to galloping
+			 * and moves whole blocks found with exponential search.
+			 * Complexity is O(n + m), or O(log(n + m)) for runs that are not interleaved
+			 */
+
+			void merge_at(const std::size_t i) noexcept {
+				auto [first_base, first_size] = runs[i];
+				auto [second_base, second_size] = runs[i + 1];
+
+				runs[i].size += second_size;
+				runs.erase(runs.begin() + i + 1);
+
+				const auto first = begin + first_base;
+				const auto second = begin + second_base;
+
+				// Elements of the first run that stay in place
+				const auto skipped = gallop(first, first_size, [&](const T& x) { return !cmp(*second, x); });
+				first_size -= skipped;
+
+				if (first_size == 0)
+					return;
+
+				// Elements of the second run that stay in place
+				second_size = gallop(second, second_size, [&](const T& x) { return cmp(x, *(second - 1)); });
+
+				if (second_size == 0)
+					return;
+
+				std::uninitialized_move(first + skipped, second, sort_holder);
+
+				std::size_t i_first = 0, i_second = 0;
+				auto dest = first + skipped;
+
+				while (i_first < first_size && i_second < second_size) {
+					std::size_t first_wins = 0, second_wins = 0;
+
+					// One element at a time until one of the runs starts winning consistently
+
+					while (i_first < first_size && i_second < second_size) {
+						if (cmp(*(second + i_second), sort_holder[i_first])) {
+							*dest++ = std::move(*(second + i_second++));
+							first_wins = 0;
+
+							if (++second_wins >= min_gallop)
+								break;
+						} else {
+							*dest++ = std::move(sort_holder[i_first++]);
+							second_wins = 0;
+
+							if (++first_wins >= min_gallop)
+								break;
+						}
+					}
+
+					// Galloping while it pays off
+
+					while (i_first < first_size && i_second < second_size) {
+						first_wins = gallop(sort_holder + i_first, first_size - i_first, [&](const T& x) {
+							return !cmp(*(second + i_second), x);
+						});
+
+						dest = std::move(sort_holder + i_first, sort_holder + i_first + first_wins, dest);
+						i_first += first_wins;
+
+						if (i_first == first_size)
+							break;
+
+						second_wins = gallop(second + i_second, second_size - i_second, [&](const T& x) {
+							return cmp(x, sort_holder[i_first]);
+						});
+
+						dest = std::move(second + i_second, second + i_second + second_wins, dest);
+						i_second += second_wins;
+
+						if (min_gallop > 1)
+							--min_gallop;
+
+						if (first_wins < MIN_GALLOP && second_wins < MIN_GALLOP)
+							break;
+					}
+
+					min_gallop += 2;
+				}
+
+				// Rest of the second run is already in place
+				std::move(sort_holder + i_first, sort_holder + first_size, dest);
+				std::destroy(sort_holder, sort_holder + first_size);
+			}
+
+			/**
+			 * Pushes new run to the stack and merges runs until invariants hold:
+			 * len[i - 2] > len[i - 1] + len[i] and len[i - 1] > len[i].
+			 * It keeps the stack logarithmic and merges balanced
+			 */
+
+			void push_run(const std::size_t base, const std::size_t size) noexcept {
+				runs.push_back({ base, size });
+
+				while (runs.size() > 1) {
+					auto n = runs.size() - 2;
+
+					if ((n > 0 && runs[n - 1].size <= runs[n].size + runs[n + 1].size)
+							|| (n > 1 && runs[n - 2].size <= runs[n - 1].size + runs[n].size)) {
+						if (runs[n - 1].size < runs[n + 1].size)
+							--n;
+					} else if (runs[n].size > runs[n + 1].size) {
+						break;
+					}
+
+					merge_at(n);
+				}
+			}
+
+			/** Merges all pending runs */
+
+			void collapse() noexcept {
+				while (runs.size() > 1) {
+					auto n = runs.size() - 2;
+
+					if (n > 0 && runs[n - 1].size < runs[n + 1].size)
+						--n;
+
+					merge_at(n);
+				}
+			}
+		};
+	}
+
 	/**
-	 * Generic implementation of out-of-place
-	 * stable merge sorting algorithm.
-	 * Complexity is O(n * log(n))
+	 * Adaptive stable natural merge sort (TimSort).
+	 * Detects ascending and strictly descending runs,
+	 * extends short runs with binary insertion sort,
+	 * merges runs keeping stack invariants and uses galloping
+	 * when one of the runs dominates.
+	 * Complexity is O(n * log(n)), O(n) for presorted data
 	 *
 	 * @param begin iterator to the beginning of the collection
 	 * @param end iterator to the end of the collection
-	 * @param cmp comparator function. As default, std::less<T> is used.
+	 * @param cmp comparator function (strict order). As default, std::less<T> is used.
 	 */
 
-	template <typename T, typename RandomAccessIterator, typename Cmp = std::less<T>> void merge_sort(
+	template <typename T, typename RandomAccessIterator, typename Cmp = std::less<T>> void natural_merge_sort(
 			RandomAccessIterator begin,
 			RandomAccessIterator end,
 			const Cmp cmp
 	) noexcept {
-		if (begin == end || begin + 1 == end)
+		const std::size_t size = end - begin;
+
+		if (size < 2)
 			return;
 
-		const auto mid = begin + (end - begin) / 2;
+		const auto min_run = natural::min_run_length(size);
+		natural::sorter<T, RandomAccessIterator, Cmp> sorter(begin, size, cmp);
 
-		merge_sort<T>(begin, mid, cmp);
-		merge_sort<T>(mid, end, cmp);
+		for (std::size_t base = 0; base < size;) {
+			auto run_size = natural::count_run(begin + base, end, cmp);
 
-		int i = 0, q = 0;
+			if (run_size < min_run) {
+				const auto forced_size = std::min(min_run, size - base);
+				natural::binary_insertion_sort(begin + base, begin + base + run_size, begin + base + forced_size, cmp);
+				run_size = forced_size;
+			}
 
-		auto* const sort_holder = new T[end - begin];
+			sorter.push_run(base, run_size);
+			base += run_size;
+		}
 
-		while (begin + i != mid && mid + q != end) {
-			if (cmp(*(begin + i), *(mid + q))) {
-				sort_holder[i + q] = *(begin + i);
-				++i;
-			} else {
-				sort_holder[i + q] = *(mid + q);
-				++q;
+		sorter.collapse();
+	}
+
+	// ############################### Parallel Merge Sort ###############################
+
+	/**
+	 * Default number of elements in the range below which
+	 * parallel merge sort falls back to the sequential one
+	 */
+
+	constexpr std::size_t PARALLEL_SORT_GRAIN = 1 << 14;
+
+	namespace parallel {
+
+		/**
+		 * Runs parts of the job on separate threads.
+		 * Last part is executed on the calling thread.
+		 * Returns when all parts are finished (fork-join)
+		 *
+		 * @param parts number of parts
+		 * @param job function that accepts number of the part
+		 */
+
+		template <typename F> void run_parts(const std::size_t parts, const F& job) noexcept {
+			std::vector<std::thread> workers;
+			workers.reserve(parts - 1);
+
+			for (std::size_t part = 0; part + 1 < parts; ++part)
+				workers.emplace_back(job, part);
+
+			job(parts - 1);
+
+			for (auto& worker : workers)
+				worker.join();
+		}
+
+		/**
+		 * Co-ranking of the stable merge of two sorted ranges.
+		 * Finds how many elements of the first range are placed
+		 * among the first `rank` elements of the merged sequence.
+		 * Merge takes element from the second range only if cmp(second, first),
+		 * so equal elements keep their order.
+		 * Complexity is O(log(n + m))
+		 *
+		 * @param rank number of elements in the merged prefix
+		 * @param first iterator to the beginning of the first range
+		 * @param first_size size of the first range
+		 * @param second iterator to the beginning of the second range
+		 * @param second_size size of the second range
+		 * @param cmp comparator function
+		 * @return number of elements taken from the first range
+		 */
+
+		template <typename RandomAccessIterator, typename Cmp> std::size_t co_rank(
+				const std::size_t rank,
+				const RandomAccessIterator first,
+				const std::size_t first_size,
+				const RandomAccessIterator second,
+				const std::size_t second_size,
+				const Cmp cmp
+		) noexcept {
+			std::size_t i = std::min(rank, first_size);
+			std::size_t j = rank - i;
+			std::size_t i_low = rank > second_size ? rank - second_size : 0;
+			std::size_t j_low = rank > first_size ? rank - first_size : 0;
+
+			while (true) {
+				if (i > 0 && j < second_size && cmp(*(second + j), *(first + (i - 1)))) {
+					// first[i - 1] goes after second[j] -> too many elements from the first range
+					const auto delta = (i - i_low + 1) / 2;
+					j_low = j;
+					i -= delta;
+					j += delta;
+				} else if (j > 0 && i < first_size && !cmp(*(second + (j - 1)), *(first + i))) {
+					// first[i] goes before second[j - 1] -> too few elements from the first range
+					const auto delta = (j - j_low + 1) / 2;
+					i_low = i;
+					i += delta;
+					j -= delta;
+				} else {
+					return i;
+				}
 			}
 		}
 
-		while (begin + i != mid) {
-			sort_holder[i + q] = *(begin + i);
-			++i;
+		/**
+		 * Sequential merge of two sorted ranges into the uninitialized output.
+		 * Elements are move-constructed into the output.
+		 * Complexity is O(n + m)
+		 */
+
+		template <typename T, typename RandomAccessIterator, typename Cmp> void merge(
+				RandomAccessIterator first,
+				const RandomAccessIterator first_end,
+				RandomAccessIterator second,
+				const RandomAccessIterator second_end,
+				T* out,
+				const Cmp cmp
+		) noexcept {
+			while (first != first_end && second != second_end)
+				std::construct_at(out++, std::move(cmp(*second, *first) ? *second++ : *first++));
+
+			out = std::uninitialized_move(first, first_end, out);
+			std::uninitialized_move(second, second_end, out);
 		}
 
-		while (mid + q != end) {
-			sort_holder[i + q] = *(mid + q);
-			++q;
+		/**
+		 * Merges two sorted halves [begin, mid) and [mid, end) in parallel.
+		 * Output is split into equal parts, borders of every part
+		 * in both halves are found with co-ranking (merge path),
+		 * so every thread merges its own part independently.
+		 * Complexity is O(n / threads + log(n))
+		 *
+		 * @param holder uninitialized buffer of at least (end - begin) elements
+		 * @param threads number of threads to use
+		 */
+
+		template <typename T, typename RandomAccessIterator, typename Cmp> void merge_halves(
+				const RandomAccessIterator begin,
+				const RandomAccessIterator mid,
+				const RandomAccessIterator end,
+				T* const holder,
+				const std::size_t threads,
+				const Cmp cmp
+		) noexcept {
+			const std::size_t first_size = mid - begin;
+			const std::size_t second_size = end - mid;
+			const std::size_t size = first_size + second_size;
+
+			// Borders are found before merging starts, since merge moves elements out of the halves
+			std::vector<std::size_t> first_borders(threads + 1);
+
+			for (std::size_t part = 0; part <= threads; ++part)
+				first_borders[part] = co_rank(size * part / threads, begin, first_size, mid, second_size, cmp);
+
+			run_parts(threads, [&](const std::size_t part) {
+				const auto rank_begin = size * part / threads;
+				const auto rank_end = size * (part + 1) / threads;
+				const auto i_begin = first_borders[part];
+				const auto i_end = first_borders[part + 1];
+
+				merge(
+						begin + i_begin, begin + i_end,
+						mid + (rank_begin - i_begin), mid + (rank_end - i_end),
+						holder + rank_begin, cmp
+				);
+			});
+
+			run_parts(threads, [&](const std::size_t part) {
+				const auto rank_begin = size * part / threads;
+				const auto rank_end = size * (part + 1) / threads;
+				std::move(holder + rank_begin, holder + rank_end, begin + rank_begin);
+				std::destroy(holder + rank_begin, holder + rank_end);
+			});
+		}
+
+		/**
+		 * Fork-join step of the parallel merge sort.
+		 * Left half is sorted on the new thread with half of the threads,
+		 * right half is sorted on the current thread with the rest of them.
+		 *
+		 * @param holder uninitialized buffer of at least (end - begin) elements
+		 * @param threads number of threads available for this range
+		 * @param grain size of the range below which sequential sort is used
+		 */
+
+		template <typename T, typename RandomAccessIterator, typename Cmp> void merge_sort(
+				const RandomAccessIterator begin,
+				const RandomAccessIterator end,
+				const Cmp cmp,
+				T* const holder,
+				const std::size_t threads,
+				const std::size_t grain
+		) noexcept {
+			const std::size_t size = end - begin;
+
+			if (threads < 2 || size <= grain) {
+				natural_merge_sort<T>(begin, end, cmp);
+				return;
+			}
+
+			const auto mid = begin + size / 2;
+			const auto left_threads = threads / 2;
+
+			std::thread left_sorter([&] { merge_sort<T>(begin, mid, cmp, holder, left_threads, grain); });
+			merge_sort<T>(mid, end, cmp, holder + size / 2, threads - left_threads, grain);
+			left_sorter.join();
+
+			merge_halves<T>(begin, mid, end, holder, threads, cmp);
 		}
+	}
 
-		for (int step = 0; step < i + q; ++step)
-			*(begin + step) = sort_holder[step];
+	/**
+	 * Parallel version of the stable merge sort.
+	 * Recursion is split between threads (fork-join),
+	 * merging of the halves is also parallel (see parallel::merge_halves).
+	 * Ranges with size less or equal to grain are sorted sequentially
+	 * with natural_merge_sort, so presorted input is sorted in O(n).
+	 * Stable, the order doesn't depend on the number of threads.
+	 * Complexity is O(n * log(n) / threads + log(n)^2)
+	 *
+	 * @param begin iterator to the beginning of the collection
+	 * @param end iterator to the end of the collection
+	 * @param cmp comparator function. As default, std::less<T> is used.
+	 * @param grain size of the range below which sequential sort is used
+	 * @param threads number of threads to use. By default, all hardware threads are used
+	 */
+
+	template <typename T, typename RandomAccessIterator, typename Cmp = std::less<T>> void parallel_merge_sort(
+			RandomAccessIterator begin,
+			RandomAccessIterator end,
+			const Cmp cmp,
+			const std::size_t grain = PARALLEL_SORT_GRAIN,
+			const std::size_t threads = std::thread::hardware_concurrency()
+	) noexcept {
+		const std::size_t size = end - begin;
+
+		if (threads < 2 || size <= grain) {
+			natural_merge_sort<T>(begin, end, cmp);
+			return;
+		}
 
-		delete[] sort_holder;
+		auto* const sort_holder = std::allocator<T>().allocate(size);
+		parallel::merge_sort<T>(begin, end, cmp, sort_holder, threads, grain);
+		std::allocator<T>().deallocate(sort_holder, size);
 	}
 
 	// ############################### AVL Tree Implementation ###############################
@@ -1373,10 +1858,10 @@ int main() {
 		points[++i] = std::make_pair(seg.end, seg);
 	}
 
-	dsa_hw::merge_sort<std::pair<dsa_hw::point, dsa_hw::segment>>(points.begin(), points.end(), [](const auto& lhs, const auto& rhs) {
+	dsa_hw::parallel_merge_sort<std::pair<dsa_hw::point, dsa_hw::segment>>(points.begin(), points.end(), [](const auto& lhs, const auto& rhs) {
 		if (lhs.first.x == rhs.first.x) {
 			if (lhs.first.y == rhs.first.y)
-				return lhs.first.is_begin();
+				return lhs.first.is_begin() && !rhs.first.is_begin();
 			return lhs.first.y < rhs.first.y;
 		}
 		return lhs.first.x < rhs.first.x;